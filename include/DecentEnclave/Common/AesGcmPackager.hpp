@@ -8,7 +8,9 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
+#include <array>
 #include <tuple>
 #include <vector>
 
@@ -17,6 +19,7 @@
 #include <mbedTLScpp/SecretVector.hpp>
 
 #include "Platform/AesGcm.hpp"
+#include "AesGcmPadding.hpp"
 #include "Exceptions.hpp"
 
 
@@ -42,13 +45,20 @@ namespace Common
 // Data                     (Encrypted)         - variable Size
 // ----- Padding part
 // Padding bytes            (Encrypted)         - variable Size
-
-template<typename _AesGcmOneGoType>
+//
+// The size of the padding is decided by the padding policy
+// (see AesGcmPadding.hpp), given the sealed block size of the packager.
+
+template<
+	typename _AesGcmOneGoType,
+	typename _PaddingPolicy = AesGcmPadding::FixedBlock
+>
 class AesGcmPackager
 {
 public: // static members:
 
 	using CryptorType = _AesGcmOneGoType;
+	using PaddingPolicy = _PaddingPolicy;
 	static constexpr size_t sk_keyBitSize = CryptorType::sk_keyBitSize;
 	static constexpr size_t sk_keyByteSize = CryptorType::sk_keyByteSize;
 	static constexpr size_t sk_ivSize = 12;
@@ -91,11 +101,8 @@ public: // static members:
 			inMetaSize +
 			inDataSize;
 
-		const size_t totalBlockNum =
-			(totalDataSize / inSealedBlockSize) +
-			((totalDataSize % inSealedBlockSize) == 0 ? 0 : 1);
-
-		const size_t totalBlockSize = totalBlockNum * inSealedBlockSize;
+		const size_t totalBlockSize =
+			PaddingPolicy::GetPaddedSize(totalDataSize, inSealedBlockSize);
 
 		const size_t padSize = totalBlockSize - totalDataSize;
 
@@ -176,17 +183,60 @@ public:
 
 	AesGcmPackager(const AesGcmPackager& rhs) = delete;
 
+	/**
+	 * \brief Get the total size of the sealed package that will be produced
+	 *        by this packager, so the caller can prepare a buffer for
+	 *        `PackInto`.
+	 *
+	 * \param keyMetaSize Size of the key metadata.
+	 * \param metaSize    Size of the metadata.
+	 * \param dataSize    Size of the data.
+	 *
+	 * \return The size of the sealed package, in bytes.
+	 */
+	size_t GetPackSize(
+		size_t keyMetaSize,
+		size_t metaSize,
+		size_t dataSize
+	) const
+	{
+		return std::get<0>(
+			GetTotalSealedBlockSize(
+				m_sealedBlockSize,
+				keyMetaSize,
+				metaSize,
+				dataSize
+			)
+		);
+	}
+
+	/**
+	 * \brief Seal the given data directly into the buffer provided by the
+	 *        caller. The header, the cipher text, and the tag are all written
+	 *        into that buffer, and the encryption is done in place, so no
+	 *        intermediate buffer is allocated.
+	 *
+	 * \param outBuf     The output buffer.
+	 * \param outBufSize Size of the output buffer, which must be exactly the
+	 *                   size returned by `GetPackSize`.
+	 * \param keyMeta    The key metadata (in plain text, but MACed).
+	 * \param meta       The metadata (encrypted).
+	 * \param data       The data (encrypted).
+	 * \param addData    Additional data to be MACed (not included in package).
+	 * \param rand       The random bit generator used to generate IV.
+	 *
+	 * \return The tag/MAC of the package.
+	 */
 	template<
 		typename _KeyMetaCtnType, bool _KeyMetaCtnSecrecy,
 		typename _MetaCtnType,    bool _MetaCtnSecrecy,
 		typename _DataCtnType,    bool _DataCtnSecrecy,
 		typename _AddCtnType,     bool _AddCtnSecrecy
 	>
-	std::pair<
-		std::vector<uint8_t>,
-		std::array<uint8_t, 16>
-	>
-	Pack(
+	std::array<uint8_t, 16>
+	PackInto(
+		void* outBuf,
+		size_t outBufSize,
 		const mbedTLScpp::ContCtnReadOnlyRef<_KeyMetaCtnType, _KeyMetaCtnSecrecy>& keyMeta,
 		const mbedTLScpp::ContCtnReadOnlyRef<_MetaCtnType, _MetaCtnSecrecy>& meta,
 		const mbedTLScpp::ContCtnReadOnlyRef<_DataCtnType, _DataCtnSecrecy>& data,
@@ -194,8 +244,62 @@ public:
 		mbedTLScpp::RbgInterface& rand
 	)
 	{
-		using namespace mbedTLScpp;
+		return PackInto(
+			outBuf, outBufSize,
+			keyMeta.BeginBytePtr(), keyMeta.GetRegionSize(),
+			meta.BeginBytePtr(),    meta.GetRegionSize(),
+			data.BeginBytePtr(),    data.GetRegionSize(),
+			addData.BeginBytePtr(), addData.GetRegionSize(),
+			rand
+		);
+	}
+
+	/**
+	 * \brief Same as the `PackInto` above, but takes raw pointers to the
+	 *        input regions, so callers holding a plain buffer (e.g., a socket
+	 *        send buffer) don't need to wrap it in a container first.
+	 */
+	std::array<uint8_t, 16>
+	PackInto(
+		void* outBuf,
+		size_t outBufSize,
+		const void* keyMeta, size_t keyMetaSize,
+		const void* meta,    size_t metaSize,
+		const void* data,    size_t dataSize,
+		const void* addData, size_t addDataSize,
+		mbedTLScpp::RbgInterface& rand
+	)
+	{
+		IVType iv;
+		rand.Rand(iv, sizeof(IVType));
+
+		return PackInto(
+			outBuf, outBufSize,
+			keyMeta, keyMetaSize,
+			meta,    metaSize,
+			data,    dataSize,
+			addData, addDataSize,
+			iv
+		);
+	}
 
+	/**
+	 * \brief Same as the `PackInto` above, but uses the given IV instead of
+	 *        generating a random one.
+	 *        The caller is responsible for never reusing an IV under the
+	 *        same key (e.g., by deriving it from a message counter).
+	 */
+	std::array<uint8_t, 16>
+	PackInto(
+		void* outBuf,
+		size_t outBufSize,
+		const void* keyMeta, size_t keyMetaSize,
+		const void* meta,    size_t metaSize,
+		const void* data,    size_t dataSize,
+		const void* addData, size_t addDataSize,
+		const IVType& iv
+	)
+	{
 		size_t totalPackSize = 0;
 		size_t packAddSize = 0;
 		size_t encryptSize = 0;
@@ -203,135 +307,324 @@ public:
 		std::tie(totalPackSize, packAddSize, encryptSize) =
 			GetTotalSealedBlockSize(
 				m_sealedBlockSize,
-				keyMeta.GetRegionSize(),
-				meta.GetRegionSize(),
-				data.GetRegionSize()
+				keyMetaSize,
+				metaSize,
+				dataSize
 			);
 
-		// ============ Build Input Package
-		SecretVector<uint8_t> inputPkg(encryptSize, 0);
+		if (outBufSize != totalPackSize)
+		{
+			throw Exception(
+				"AesGcmPackager::PackInto - "
+				"The given buffer size doesn't match the package size."
+			);
+		}
+
+		uint8_t* finPackage = static_cast<uint8_t*>(outBuf);
+		std::array<uint8_t, 16> tag; // <<= The tag/MAC to be returned.
+
+		// Positions in the final packages:
+		constexpr size_t fpTagPos       = 0;
+		constexpr size_t fpIvPos        = fpTagPos + sizeof(TagType);
+		constexpr size_t fpPaySizePos   = fpIvPos + sizeof(IVType);
+		constexpr size_t fpKMetaSizePos = fpPaySizePos + sizeof(uint64_t);
+		constexpr size_t fpKMetaPos     = fpKMetaSizePos + sizeof(uint64_t);
+		const     size_t fpEncDataPos   = fpKMetaPos + keyMetaSize;
+
+		// ============ Build Header
+		{
+			// IV
+			std::memcpy(finPackage + fpIvPos, iv, sizeof(IVType));
+			// Payload Size
+			const uint64_t payloadSize = encryptSize;
+			std::memcpy(
+				finPackage + fpPaySizePos,
+				&payloadSize,
+				sizeof(payloadSize)
+			);
+			// Key Meta Size
+			const uint64_t keyMetaSize64 = keyMetaSize;
+			std::memcpy(
+				finPackage + fpKMetaSizePos,
+				&keyMetaSize64,
+				sizeof(keyMetaSize64)
+			);
+			// Key Meta
+			if (keyMetaSize > 0)
+			{
+				std::memcpy(
+					finPackage + fpKMetaPos,
+					keyMeta,
+					keyMetaSize
+				);
+			}
+		}
 
+		// ============ Build Input Package (in place)
+		uint8_t* inputPkg = finPackage + fpEncDataPos;
 		{
 			// Positions in the input packages:
 			constexpr size_t ipMetaSizePos = 0;
 			constexpr size_t ipDataSizePos = ipMetaSizePos + sizeof(uint64_t);
 			constexpr size_t ipMetaPos     = ipDataSizePos + sizeof(uint64_t);
-			//const     size_t ipDataPos     = ipMetaPos + meta.GetRegionSize();
-			// Ensure we don't leak info when using local vars.
+			const     size_t ipDataPos     = ipMetaPos + metaSize;
+			const     size_t ipPadPos      = ipDataPos + dataSize;
 
 			// Meta Size
-			uint64_t& metaSize =
-				*reinterpret_cast<uint64_t*>(inputPkg.data() + ipMetaSizePos);
-			metaSize = meta.GetRegionSize();
+			const uint64_t metaSize64 = metaSize;
+			std::memcpy(
+				inputPkg + ipMetaSizePos,
+				&metaSize64,
+				sizeof(metaSize64)
+			);
 			// Data Size
-			uint64_t& dataSize =
-				*reinterpret_cast<uint64_t*>(inputPkg.data() + ipDataSizePos);
-			dataSize = data.GetRegionSize();
-			// Meta
-			//std::copy(
-			// 	meta.BeginBytePtr(),
-			// 	meta.EndBytePtr(),
-			// 	inputPkg.data() + ipMetaPos
-			// );
+			const uint64_t dataSize64 = dataSize;
 			std::memcpy(
-				inputPkg.data() + ipMetaPos,
-				meta.BeginBytePtr(),
-				meta.GetRegionSize()
+				inputPkg + ipDataSizePos,
+				&dataSize64,
+				sizeof(dataSize64)
 			);
+			// Meta
+			if (metaSize > 0)
+			{
+				std::memcpy(
+					inputPkg + ipMetaPos,
+					meta,
+					metaSize
+				);
+			}
 			// Data
-			//std::copy(
-			// 	data.BeginBytePtr(),
-			// 	data.EndBytePtr(),
-			// 	inputPkg.data() + ipMetaPos + metaSize
-			// );
-			std::memcpy(
-				inputPkg.data() + ipMetaPos + metaSize,
-				data.BeginBytePtr(),
+			if (dataSize > 0)
+			{
+				std::memcpy(
+					inputPkg + ipDataPos,
+					data,
+					dataSize
+				);
+			}
+			// Padding
+			std::memset(
+				inputPkg + ipPadPos,
+				0,
+				encryptSize - ipPadPos
+			);
+		}
+
+		// ============ Encrypt (in place)
+		// The header and the caller's additional data are MACed as
+		// separated segments, so no concatenated copy is needed.
+		tag = m_aesGcm.EncryptInPlace(
+			finPackage + fpIvPos, sizeof(IVType),
+			{
+				{ finPackage + fpIvPos, packAddSize },
+				{ addData, addDataSize },
+			},
+			inputPkg, encryptSize
+		);
+
+		// Copy Tag
+		std::memcpy(finPackage + fpTagPos, tag.data(), tag.size());
+
+		return tag;
+	}
+
+	template<
+		typename _KeyMetaCtnType, bool _KeyMetaCtnSecrecy,
+		typename _MetaCtnType,    bool _MetaCtnSecrecy,
+		typename _DataCtnType,    bool _DataCtnSecrecy,
+		typename _AddCtnType,     bool _AddCtnSecrecy
+	>
+	std::pair<
+		std::vector<uint8_t>,
+		std::array<uint8_t, 16>
+	>
+	Pack(
+		const mbedTLScpp::ContCtnReadOnlyRef<_KeyMetaCtnType, _KeyMetaCtnSecrecy>& keyMeta,
+		const mbedTLScpp::ContCtnReadOnlyRef<_MetaCtnType, _MetaCtnSecrecy>& meta,
+		const mbedTLScpp::ContCtnReadOnlyRef<_DataCtnType, _DataCtnSecrecy>& data,
+		const mbedTLScpp::ContCtnReadOnlyRef<_AddCtnType, _AddCtnSecrecy>& addData,
+		mbedTLScpp::RbgInterface& rand
+	)
+	{
+		std::vector<uint8_t> finPackage(
+			GetPackSize(
+				keyMeta.GetRegionSize(),
+				meta.GetRegionSize(),
 				data.GetRegionSize()
+			)
+		);
+
+		std::array<uint8_t, 16> tag = PackInto(
+			finPackage.data(),
+			finPackage.size(),
+			keyMeta,
+			meta,
+			data,
+			addData,
+			rand
+		);
+
+		return std::make_pair(std::move(finPackage), tag);
+	}
+
+
+	/**
+	 * \brief Unseal the given package in place. The cipher text inside the
+	 *        package is decrypted directly in the given buffer, so no
+	 *        intermediate buffer is allocated.
+	 *        If the authentication fails, an exception is thrown, and the
+	 *        content of the buffer should be discarded.
+	 *
+	 * \param pkgBuf  The buffer holding the package.
+	 * \param pkgSize Size of the package.
+	 * \param addData Additional data that was MACed with the package.
+	 * \param inTag   The expected tag/MAC; can be nullptr if not needed.
+	 *
+	 * \return Pointers (into the given buffer) to, and sizes of, the data and
+	 *         the metadata.
+	 */
+	template<
+		typename _AddCtnType,  bool _AddCtnSecrecy
+	>
+	std::tuple<
+		uint8_t* /* Data */,
+		size_t   /* Data Size */,
+		uint8_t* /* Meta */,
+		size_t   /* Meta Size */
+	>
+	UnpackInPlace(
+		void* pkgBuf,
+		size_t pkgSize,
+		const mbedTLScpp::ContCtnReadOnlyRef<_AddCtnType, _AddCtnSecrecy>& addData,
+		const std::array<uint8_t, 16>* inTag
+	)
+	{
+		return UnpackInPlace(
+			pkgBuf, pkgSize,
+			addData.BeginBytePtr(), addData.GetRegionSize(),
+			inTag
+		);
+	}
+
+	std::tuple<
+		uint8_t* /* Data */,
+		size_t   /* Data Size */,
+		uint8_t* /* Meta */,
+		size_t   /* Meta Size */
+	>
+	UnpackInPlace(
+		void* pkgBuf,
+		size_t pkgSize,
+		const void* addData, size_t addDataSize,
+		const std::array<uint8_t, 16>* inTag
+	)
+	{
+		uint8_t* package = static_cast<uint8_t*>(pkgBuf);
+
+		// Positions in the packages:
+		constexpr size_t fpTagPos       = 0;
+		constexpr size_t fpIvPos        = fpTagPos + sizeof(TagType);
+		constexpr size_t fpPaySizePos   = fpIvPos + sizeof(IVType);
+		constexpr size_t fpKMetaSizePos = fpPaySizePos + sizeof(uint64_t);
+		constexpr size_t fpKMetaPos     = fpKMetaSizePos + sizeof(uint64_t);
+
+		if (pkgSize < sk_sealMetaSize)
+		{
+			throw Exception(
+				"AesGcmPackager::UnpackInPlace - "
+				"The given package's size is smaller than expected."
 			);
 		}
 
-		// ============ Build Final Package
-		std::vector<uint8_t> finPackage(totalPackSize);  // <<= The final package to be returned.
-		std::array<uint8_t, 16> tag;                     // <<= The tag/MAC to be returned.
+		uint64_t payloadSize = 0;
+		std::memcpy(&payloadSize, package + fpPaySizePos, sizeof(payloadSize));
+		uint64_t keyMetaSize = 0;
+		std::memcpy(&keyMetaSize, package + fpKMetaSizePos, sizeof(keyMetaSize));
 
+		if (
+			(keyMetaSize > pkgSize) ||
+			(payloadSize > pkgSize) ||
+			(pkgSize != fpKMetaPos + keyMetaSize + payloadSize)
+		)
 		{
-			// Positions in the final packages:
-			constexpr size_t fpTagPos       = 0;
-			constexpr size_t fpIvPos        = fpTagPos + sizeof(TagType);
-			constexpr size_t fpPaySizePos   = fpIvPos + sizeof(IVType);
-			constexpr size_t fpKMetaSizePos = fpPaySizePos + sizeof(uint64_t);
-			constexpr size_t fpKMetaPos     = fpKMetaSizePos + sizeof(uint64_t);
-			const     size_t fpEncDataPos   = fpKMetaPos + keyMeta.GetRegionSize();
-
-			// Generate IV
-			rand.Rand(finPackage.data() + fpIvPos, sizeof(IVType));
-			// Payload Size
-			uint64_t& payloadSize =
-				*reinterpret_cast<uint64_t*>(finPackage.data() + fpPaySizePos);
-			payloadSize = encryptSize;
-			// Key Meta Size
-			uint64_t& keyMetaSize =
-				*reinterpret_cast<uint64_t*>(finPackage.data() + fpKMetaSizePos);
-			keyMetaSize = keyMeta.GetRegionSize();
-			// Key Meta
-			std::memcpy(
-				finPackage.data() + fpKMetaPos,
-				keyMeta.BeginBytePtr(),
-				keyMeta.GetRegionSize()
+			throw Exception(
+				"AesGcmPackager::UnpackInPlace - "
+				"The package size doesn't match the expected size."
 			);
+		}
 
-			std::vector<uint8_t> encrypted;
+		const size_t fpEncDataPos = fpKMetaPos + keyMetaSize;
+		uint8_t* outputPkg = package + fpEncDataPos;
 
-			if (addData.GetRegionSize() > 0)
+		// Check input tag
+		if (inTag != nullptr)
+		{
+			static_assert(sizeof(TagType) == 16, "Programming Error");
+			if (
+				std::memcmp(
+					package + fpTagPos,
+					inTag->data(),
+					sizeof(TagType)
+				) != 0
+			)
 			{
-				// Build Full Add Data
-				std::vector<uint8_t> pkgAddData;
-				pkgAddData.reserve(packAddSize + addData.GetRegionSize());
-				pkgAddData.insert(
-					pkgAddData.end(),
-					finPackage.begin() + fpIvPos,
-					finPackage.begin() + fpEncDataPos
-				);
-				pkgAddData.insert(
-					pkgAddData.end(),
-					addData.BeginBytePtr(),
-					addData.EndBytePtr()
-				);
-
-				// Encrypt
-				std::tie(encrypted, tag) = m_aesGcm.Encrypt(
-					CtnByteRgR<fpIvPos, fpIvPos + sizeof(IVType)>(finPackage),
-					CtnFullR(pkgAddData),
-					CtnFullR(inputPkg)
+				throw Exception(
+					"AesGcmPackager::UnpackInPlace - "
+					"The tag/MAC contained in the message package "
+					"doesn't match the given one."
 				);
 			}
-			else
+		}
+
+		// Decrypt (in place)
+		m_aesGcm.DecryptInPlace(
+			package + fpIvPos, sizeof(IVType),
 			{
-				// Encrypt
-				std::tie(encrypted, tag) = m_aesGcm.Encrypt(
-					CtnByteRgR<fpIvPos, fpIvPos + sizeof(IVType)>(finPackage),
-					CtnByteRgR(finPackage, fpIvPos, fpEncDataPos),
-					CtnFullR(inputPkg)
-				);
-			}
+				{ package + fpIvPos, fpEncDataPos - fpIvPos },
+				{ addData, addDataSize },
+			},
+			outputPkg, payloadSize,
+			package + fpTagPos
+		);
 
-			// EXCEPTION_ASSERT(
-			// 	finPackage.size() == (fpEncDataPos + encrypted.size()),
-			// 	"The package size calculation result is wrong."
-			// );
+		// Separating Metadata and data.
+		constexpr size_t opMetaSizePos = 0;
+		constexpr size_t opDataSizePos = opMetaSizePos + sizeof(uint64_t);
+		constexpr size_t opMetaPos     = opDataSizePos + sizeof(uint64_t);
 
-			// Copy Tag
-			std::memcpy(finPackage.data() + fpTagPos, tag.data(), tag.size());
-			// Copy Encrypted Data
-			std::memcpy(
-				finPackage.data() + fpEncDataPos,
-				encrypted.data(),
-				encrypted.size()
+		if (payloadSize < opMetaPos)
+		{
+			throw Exception(
+				"AesGcmPackager::UnpackInPlace - "
+				"The encrypted payload package size "
+				"is smaller than the expected size."
+			);
+		}
+
+		uint64_t metaSize = 0;
+		std::memcpy(&metaSize, outputPkg + opMetaSizePos, sizeof(metaSize));
+		uint64_t dataSize = 0;
+		std::memcpy(&dataSize, outputPkg + opDataSizePos, sizeof(dataSize));
+
+		if (
+			(metaSize > payloadSize) ||
+			(dataSize > payloadSize) ||
+			(payloadSize < opMetaPos + metaSize + dataSize)
+		)
+		{
+			throw Exception(
+				"AesGcmPackager::UnpackInPlace - "
+				"The encrypted payload package size "
+				"is smaller than the expected size."
 			);
 		}
 
-		return std::make_pair(finPackage, tag);
+		return std::make_tuple(
+			outputPkg + opMetaPos + metaSize,
+			static_cast<size_t>(dataSize),
+			outputPkg + opMetaPos,
+			static_cast<size_t>(metaSize)
+		);
 	}
 
 
@@ -351,128 +644,32 @@ public:
 	{
 		using namespace mbedTLScpp;
 
-		// Decrypt and get output package.
-		SecretVector<uint8_t> outputPkg;
-		{
-			// Positions in the packages:
-			constexpr size_t fpTagPos       = 0;
-			constexpr size_t fpIvPos        = fpTagPos + sizeof(TagType);
-			constexpr size_t fpPaySizePos   = fpIvPos + sizeof(IVType);
-			constexpr size_t fpKMetaSizePos = fpPaySizePos + sizeof(uint64_t);
-			constexpr size_t fpKMetaPos     = fpKMetaSizePos + sizeof(uint64_t);
-
-			const uint64_t payloadSize =
-				*reinterpret_cast<const uint64_t*>(
-					package.BeginBytePtr() + fpPaySizePos
-				);
-			const uint64_t keyMetaSize =
-				*reinterpret_cast<const uint64_t*>(
-					package.BeginBytePtr() + fpKMetaSizePos
-				);
-
-			const size_t fpEncDataPos = fpKMetaPos + keyMetaSize;
-
-			if (package.GetRegionSize() != fpEncDataPos + payloadSize)
-			{
-				throw Exception(
-					"AesGcmPackager::Unpack - "
-					"The package size doesn't match the expected size."
-				);
-			}
-
-			if (addData.GetRegionSize() > 0)
-			{
-				// Build Full Add Data
-				std::vector<uint8_t> pkgAddData;
-				pkgAddData.reserve(
-					sk_knownAddSize + keyMetaSize + addData.GetRegionSize()
-				);
-				pkgAddData.insert(
-					pkgAddData.end(),
-					package.BeginBytePtr() + fpIvPos,
-					package.BeginBytePtr() + fpEncDataPos
-				);
-				pkgAddData.insert(
-					pkgAddData.end(),
-					addData.BeginBytePtr(),
-					addData.EndBytePtr()
-				);
-
-				outputPkg = m_aesGcm.Decrypt(
-					CtnByteRgR<fpIvPos, fpIvPos + sizeof(IVType)>(package),
-					CtnFullR(pkgAddData),
-					CtnByteRgR(package, fpEncDataPos),
-					CtnByteRgR<fpTagPos, fpTagPos + sizeof(TagType)>(package)
-				);
-			}
-			else
-			{
-				outputPkg = m_aesGcm.Decrypt(
-					CtnByteRgR<fpIvPos, fpIvPos + sizeof(IVType)>(package),
-					CtnByteRgR(package, fpIvPos, fpEncDataPos),
-					CtnByteRgR(package, fpEncDataPos),
-					CtnByteRgR<fpTagPos, fpTagPos + sizeof(TagType)>(package)
-				);
-			}
-
-			// Check input tag
-			if (inTag != nullptr)
-			{
-				static_assert(sizeof(TagType) == 16, "Programming Error");
-				if (
-					std::memcmp(
-						package.BeginBytePtr() + fpTagPos,
-						inTag->data(),
-						sizeof(TagType)
-					) != 0
-				)
-				{
-					throw Exception(
-						"AesGcmPackager::Unpack - "
-						"The tag/MAC contained in the message package "
-						"doesn't match the given one."
-					);
-				}
-			}
-		}
+		// The package is copied into a secret buffer, since it will hold the
+		// plain text once decrypted in place.
+		SecretVector<uint8_t> pkgBuf(package.GetRegionSize());
+		std::memcpy(
+			pkgBuf.data(),
+			package.BeginBytePtr(),
+			package.GetRegionSize()
+		);
+
+		uint8_t* dataPtr = nullptr;
+		size_t dataSize = 0;
+		uint8_t* metaPtr = nullptr;
+		size_t metaSize = 0;
+		std::tie(dataPtr, dataSize, metaPtr, metaSize) = UnpackInPlace(
+			pkgBuf.data(),
+			pkgBuf.size(),
+			addData,
+			inTag
+		);
 
-		// Separating Metadata and data.
 		SecretVector<uint8_t> outMeta;
 		SecretVector<uint8_t> outData;
-		{
-			constexpr size_t opMetaSizePos = 0;
-			constexpr size_t opDataSizePos = opMetaSizePos + sizeof(uint64_t);
-			constexpr size_t opMetaPos     = opDataSizePos + sizeof(uint64_t);
-
-			const uint64_t& metaSize =
-				*reinterpret_cast<const uint64_t*>(
-					outputPkg.data() + opMetaSizePos
-				);
-			const uint64_t& dataSize =
-				*reinterpret_cast<const uint64_t*>(
-					outputPkg.data() + opDataSizePos
-				);
-
-			if (outputPkg.size() < opMetaPos + metaSize + dataSize)
-			{
-				throw Exception(
-					"AesGcmPackager::Unpack - "
-					"The encrypted payload package size "
-					"is smaller than the expected size."
-				);
-			}
-
-			outMeta.insert(outMeta.end(),
-				outputPkg.data() + opMetaPos,
-				outputPkg.data() + opMetaPos + metaSize
-			);
-			outData.insert(outData.end(),
-				outputPkg.data() + opMetaPos + metaSize,
-				outputPkg.data() + opMetaPos + metaSize + dataSize
-			);
-		}
+		outMeta.insert(outMeta.end(), metaPtr, metaPtr + metaSize);
+		outData.insert(outData.end(), dataPtr, dataPtr + dataSize);
 
-		return std::make_pair(outData, outMeta);
+		return std::make_pair(std::move(outData), std::move(outMeta));
 	}
 
 private:
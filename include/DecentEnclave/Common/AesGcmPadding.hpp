@@ -0,0 +1,131 @@
+// Copyright (c) 2022 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <limits>
+
+#include "Exceptions.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Common
+{
+
+/**
+ * \brief Padding policies for sealed packages (see `AesGcmPackager`).
+ *        Each policy maps the unpadded size of a package to its padded
+ *        size, given a size parameter whose meaning depends on the policy;
+ *        `sk_defaultParam` is the parameter used by `AesGcmStreamSocket`.
+ */
+namespace AesGcmPadding
+{
+
+
+/**
+ * \brief No padding at all; the size parameter is ignored.
+ */
+class None
+{
+public: // static members:
+
+	static constexpr size_t sk_defaultParam = 1;
+
+	static size_t GetPaddedSize(size_t size, size_t /* param */)
+	{
+		return size;
+	}
+}; // class None
+
+
+/**
+ * \brief Rounds the package up to a multiple of a fixed block size
+ *        (the size parameter).
+ */
+class FixedBlock
+{
+public: // static members:
+
+	static constexpr size_t sk_defaultParam = 128;
+
+	static size_t GetPaddedSize(size_t size, size_t blockSize)
+	{
+		const size_t blockNum =
+			(size / blockSize) +
+			((size % blockSize) == 0 ? 0 : 1);
+
+		return blockNum * blockSize;
+	}
+}; // class FixedBlock
+
+
+/**
+ * \brief Rounds the package up to the next power of two, with the size
+ *        parameter as the smallest bucket. The overhead stays below 2x,
+ *        while only leaking the logarithm of the size.
+ */
+class Pow2Bucket
+{
+public: // static members:
+
+	static constexpr size_t sk_defaultParam = 64;
+
+	static size_t GetPaddedSize(size_t size, size_t minBucket)
+	{
+		size_t bucket = minBucket;
+		while (bucket < size)
+		{
+			if (bucket > (std::numeric_limits<size_t>::max() >> 1))
+			{
+				throw Exception(
+					"AesGcmPadding::Pow2Bucket - "
+					"The package size is too large"
+				);
+			}
+			bucket <<= 1;
+		}
+		return bucket;
+	}
+}; // class Pow2Bucket
+
+
+/**
+ * \brief Power-of-two buckets (starting from `sk_minBucket`) for packages
+ *        up to a cap (the size parameter), and fixed steps of the cap
+ *        beyond it; so small packages only leak the logarithm of their
+ *        size, while the overhead of large ones is bounded by the cap,
+ *        rather than by their size.
+ */
+class Capped
+{
+public: // static members:
+
+	static constexpr size_t sk_defaultParam = 16 * 1024;
+	static constexpr size_t sk_minBucket = Pow2Bucket::sk_defaultParam;
+
+	static size_t GetPaddedSize(size_t size, size_t cap)
+	{
+		if (size > cap)
+		{
+			return FixedBlock::GetPaddedSize(size, cap);
+		}
+
+		const size_t minBucket = cap < sk_minBucket ? cap : sk_minBucket;
+		const size_t bucket = Pow2Bucket::GetPaddedSize(size, minBucket);
+		// the cap may not be a power of two
+		return bucket < cap ? bucket : cap;
+	}
+}; // class Capped
+
+
+} // namespace AesGcmPadding
+
+} // namespace Common
+} // namespace DecentEnclave
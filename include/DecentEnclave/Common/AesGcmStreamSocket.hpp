@@ -8,9 +8,15 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <mbedTLScpp/Hkdf.hpp>
@@ -22,8 +28,13 @@
 #include "Internal/SimpleObj.hpp"
 #include "Internal/SimpleSysIO.hpp"
 #include "Platform/AesGcm.hpp"
+#include "Platform/Print.hpp"
+#include "Platform/Random.hpp"
 #include "AesGcmPackager.hpp"
+#include "AesGcmPadding.hpp"
 #include "AesGcmSocketHandshaker.hpp"
+#include "AsyncSocket.hpp"
+#include "Exceptions.hpp"
 
 
 namespace DecentEnclave
@@ -32,31 +43,77 @@ namespace Common
 {
 
 
-template<size_t _keyBitSize>
+/**
+ * \brief	How the IV of each record sent is generated
+ */
+enum class AesGcmIvPolicy
+{
+	/** \brief	A fresh random IV for every record (default) */
+	Random,
+	/**
+	 * \brief	IV derived from a per-key random salt and the message counter,
+	 *          so no RNG call is needed per record
+	 */
+	Counter,
+}; // enum class AesGcmIvPolicy
+
+
+template<
+	size_t _keyBitSize,
+	typename _PaddingPolicy = AesGcmPadding::FixedBlock
+>
 class AesGcmStreamSocket:
-	public Internal::SysIO::StreamSocketBase
+	public Internal::SysIO::StreamSocketBase,
+	public AsyncSendSocketIntf
 {
 public: //static members:
 
-	using Self = AesGcmStreamSocket<_keyBitSize>;
+	using Self = AesGcmStreamSocket<_keyBitSize, _PaddingPolicy>;
 	using Base = Internal::SysIO::StreamSocketBase;
+	using AsyncSendBase = AsyncSendSocketIntf;
 	using SocketType = Internal::SysIO::StreamSocketBase;
 
-	using PlatformAesGcm = Platform::AesGcmOneGoNative<_keyBitSize>;
+	using PlatformAesGcm = Platform::AesGcmSessionNative<_keyBitSize>;
 	using HandshakerType = AesGcmSocketHandshaker<_keyBitSize>;
-	using CryptoPackager = AesGcmPackager<PlatformAesGcm>;
+	using PaddingPolicy = _PaddingPolicy;
+	using CryptoPackager = AesGcmPackager<PlatformAesGcm, PaddingPolicy>;
 
 	using KeyType = typename HandshakerType::RetKeyType;
 	using AddDataType = mbedTLScpp::SecretArray<uint64_t, 3>;
+	using IVType = typename CryptoPackager::IVType;
+	/**
+	 * \brief	Additional data of a streamed chunk
+	 *          (add data || chunk index || final chunk flag)
+	 */
+	using StreamAddDataType = mbedTLScpp::SecretArray<uint64_t, 5>;
 
 	using SizedSendSizeType = uint64_t;
 
+	using StreamChunkConsumer = std::function<void(const uint8_t*, size_t)>;
+
+	/**
+	 * \brief	Schedules a job on a worker thread (e.g., by wrapping it in a
+	 *          task added to a thread pool); used by the bulk transfer mode.
+	 */
+	using BulkExecutor = std::function<void(std::function<void()>)>;
+
 	static constexpr size_t sk_keyBitSize = _keyBitSize;
 	static constexpr size_t sk_keyByteSize = sk_keyBitSize / 8;
-	static constexpr size_t sk_packBlockSize = 128;
+	/** \brief	Size parameter given to the padding policy */
+	static constexpr size_t sk_packBlockSize = PaddingPolicy::sk_defaultParam;
 	static constexpr uint64_t sk_maxCounter =
 		std::numeric_limits<uint64_t>::max();
 
+	/** \brief	Size of plain text carried by each chunk of a streamed message */
+	static constexpr size_t sk_streamChunkSize = 16 * 1024;
+	static constexpr size_t sk_streamAddDataSize =
+		sizeof(StreamAddDataType::value_type) * StreamAddDataType::sk_itemCount;
+	/** \brief	Bit of the size prefix marking the last chunk of a stream */
+	static constexpr SizedSendSizeType sk_streamFinalFlag =
+		SizedSendSizeType(1) << 63;
+	/** \brief	Size of plain text carried by each chunk of a bulk transfer */
+	static constexpr size_t sk_bulkChunkSize = 256 * 1024;
+
 	static const std::string& GetSecKeyDerLabel()
 	{
 		static const std::string s_label = "next_secret_key";
@@ -231,6 +288,271 @@ private: // static members:
 	}; // class AsyncRecvHandler
 
 
+	/**
+	 * \brief	Crypto objects owned by one worker of a bulk transfer.
+	 *          They are created on first use, so a worker that never gets
+	 *          a chunk doesn't pay for them.
+	 */
+	class BulkWorkerCtx
+	{
+	public:
+
+		BulkWorkerCtx(const KeyType& key) :
+			m_key(key),
+			m_packager(),
+			m_rand()
+		{}
+
+		CryptoPackager& GetPackager()
+		{
+			static constexpr size_t _packBlockSize = sk_packBlockSize;
+
+			if (m_packager == nullptr)
+			{
+				m_packager = Internal::Obj::Internal::make_unique<
+					CryptoPackager
+				>(m_key, _packBlockSize);
+			}
+			return *m_packager;
+		}
+
+		mbedTLScpp::RbgInterface& GetRand()
+		{
+			if (m_rand == nullptr)
+			{
+				m_rand = Internal::Obj::Internal::make_unique<
+					Platform::RandGenerator
+				>();
+			}
+			return *m_rand;
+		}
+
+	private:
+
+		const KeyType& m_key;
+		std::unique_ptr<CryptoPackager> m_packager;
+		std::unique_ptr<Platform::RandGenerator> m_rand;
+	}; // class BulkWorkerCtx
+
+
+	/**
+	 * \brief	State shared by the thread driving a bulk transfer and its
+	 *          helper workers.
+	 *          Chunks are claimed in order, once they become available.
+	 *          Helpers never wait: they return as soon as no chunk is
+	 *          available, and the driving thread schedules new ones as
+	 *          more chunks become available; so the transfer never depends
+	 *          on a helper being scheduled, and inline or single-threaded
+	 *          executors work as well.
+	 */
+	class BulkJobState
+	{
+	public: // static members:
+
+		using ChunkProcessor = std::function<void(BulkWorkerCtx&, size_t)>;
+
+		static void RunHelper(std::shared_ptr<BulkJobState> state)
+		{
+			BulkWorkerCtx ctx(state->m_key);
+			size_t idx = 0;
+			while (state->ClaimChunk(idx, true))
+			{
+				state->ProcessChunk(ctx, idx);
+			}
+		}
+
+	public:
+
+		BulkJobState(
+			const KeyType& key,
+			size_t chunkCount,
+			size_t availCount,
+			size_t maxHelpers,
+			ChunkProcessor proc
+		) :
+			m_key(key),
+			m_proc(std::move(proc)),
+			m_mutex(),
+			m_cv(),
+			m_chunkCount(chunkCount),
+			m_availCount(availCount),
+			m_nextChunk(0),
+			m_doneCount(0),
+			m_isDone(chunkCount, 0),
+			m_maxHelpers(maxHelpers),
+			m_numHelpers(0),
+			m_error()
+		{}
+
+		/**
+		 * \brief	Claims the next available chunk, without waiting.
+		 *
+		 * \param	idx     	Index of the chunk claimed.
+		 * \param	isHelper	Whether it's called by a helper, which leaves
+		 *                  	the job when there is nothing to claim.
+		 *
+		 * \return	\c false if there is nothing to claim at the moment.
+		 */
+		bool ClaimChunk(size_t& idx, bool isHelper)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!AfterLockHasAvailable())
+			{
+				if (isHelper)
+				{
+					--m_numHelpers;
+				}
+				return false;
+			}
+			idx = m_nextChunk++;
+			return true;
+		}
+
+		/**
+		 * \brief	Reserves a place for a new helper, if there are chunks
+		 *          waiting to be claimed and fewer helpers than the maximum.
+		 */
+		bool TryAddHelper()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!AfterLockHasAvailable() || (m_numHelpers >= m_maxHelpers))
+			{
+				return false;
+			}
+			++m_numHelpers;
+			return true;
+		}
+
+		void ProcessChunk(BulkWorkerCtx& ctx, size_t idx)
+		{
+			try
+			{
+				m_proc(ctx, idx);
+			}
+			catch (...)
+			{
+				SetError(std::current_exception());
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_isDone[idx] = 1;
+				++m_doneCount;
+			}
+			m_cv.notify_all();
+		}
+
+		void AddAvailable()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_availCount;
+			}
+			m_cv.notify_all();
+		}
+
+		/**
+		 * \brief	Waits until the given chunk is done, processing other
+		 *          chunks on the calling thread in the meanwhile.
+		 */
+		void WaitChunk(BulkWorkerCtx& ctx, size_t idx)
+		{
+			size_t claimed = 0;
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					ThrowIfError();
+					if (m_isDone[idx])
+					{
+						return;
+					}
+				}
+
+				if (ClaimChunk(claimed, false))
+				{
+					ProcessChunk(ctx, claimed);
+				}
+				else
+				{
+					// the chunk has been claimed by a helper that is running,
+					// since the driving thread only waits for chunks that
+					// are already available
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_cv.wait(
+						lock,
+						[this, idx]()
+						{
+							return (m_error != nullptr) || m_isDone[idx];
+						}
+					);
+				}
+			}
+		}
+
+		/**
+		 * \brief	Stops any further chunk from being claimed, and waits
+		 *          for the chunks in progress, so the buffers they refer to
+		 *          can be safely released.
+		 */
+		void Abort()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_chunkCount = m_nextChunk;
+			m_cv.notify_all();
+			m_cv.wait(
+				lock,
+				[this]()
+				{
+					return m_doneCount >= m_nextChunk;
+				}
+			);
+		}
+
+	private:
+
+		/** \brief	Must be called with the mutex locked */
+		bool AfterLockHasAvailable() const
+		{
+			return (m_error == nullptr) &&
+				(m_nextChunk < m_chunkCount) &&
+				(m_nextChunk < m_availCount);
+		}
+
+		void SetError(std::exception_ptr error)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_error == nullptr)
+			{
+				m_error = error;
+			}
+		}
+
+		/** \brief	Must be called with the mutex locked */
+		void ThrowIfError()
+		{
+			if (m_error != nullptr)
+			{
+				std::rethrow_exception(m_error);
+			}
+		}
+
+		KeyType m_key;
+		ChunkProcessor m_proc;
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		size_t m_chunkCount;
+		size_t m_availCount;
+		size_t m_nextChunk;
+		size_t m_doneCount;
+		std::vector<uint8_t> m_isDone;
+		size_t m_maxHelpers;
+		size_t m_numHelpers;
+		std::exception_ptr m_error;
+	}; // class BulkJobState
+
+
 public:
 
 	AesGcmStreamSocket() = delete;
@@ -246,18 +568,29 @@ public:
 		m_selfMakKey(maskKey),
 		m_selfAddData(),
 		m_selfAesGcm(),
+		m_ivPolicy(AesGcmIvPolicy::Random),
+		m_selfIvSalt(0),
 		m_peerSecKey(secretKey),
 		m_peerMakKey(maskKey),
 		m_peerAddData(),
 		m_peerAesGcm(),
 		m_socket(std::move(sock)),
-		m_recvBuf()
+		m_asyncSend(MakeAsyncSendQueue(m_socket.get())),
+		m_recvBuf(),
+		m_recvPos(0),
+		m_recvEnd(0),
+		m_sendBufThreshold(0),
+		m_sendBuf(),
+		m_appWriteCount(0),
+		m_recordSentCount(0)
 	{
 		RefreshSelfAesGcmer();
 		RefreshPeerAesGcmer();
 
 		RefreshSelfAddData();
 		RefreshPeerAddData();
+
+		RefreshSelfIvSalt();
 	}
 
 
@@ -275,18 +608,50 @@ public:
 		m_selfMakKey(std::move(other.m_selfMakKey)),
 		m_selfAddData(std::move(other.m_selfAddData)),
 		m_selfAesGcm(std::move(other.m_selfAesGcm)),
+		m_ivPolicy(other.m_ivPolicy),
+		m_selfIvSalt(other.m_selfIvSalt),
 		m_peerSecKey(std::move(other.m_peerSecKey)),
 		m_peerMakKey(std::move(other.m_peerMakKey)),
 		m_peerAddData(std::move(other.m_peerAddData)),
 		m_peerAesGcm(std::move(other.m_peerAesGcm)),
 		m_socket(std::move(other.m_socket)),
-		m_recvBuf(std::move(other.m_recvBuf))
-	{}
+		m_asyncSend(std::move(other.m_asyncSend)),
+		m_recvBuf(std::move(other.m_recvBuf)),
+		m_recvPos(other.m_recvPos),
+		m_recvEnd(other.m_recvEnd),
+		m_sendBufThreshold(other.m_sendBufThreshold),
+		m_sendBuf(std::move(other.m_sendBuf)),
+		m_appWriteCount(other.m_appWriteCount),
+		m_recordSentCount(other.m_recordSentCount)
+	{
+		other.m_recvPos = 0;
+		other.m_recvEnd = 0;
+	}
 
 
 	// LCOV_EXCL_START
-	/** \brief	Destructor */
-	virtual ~AesGcmStreamSocket() = default;
+	/**
+	 * \brief	Destructor. The write buffer is NOT flushed, since that would
+	 *          block on the socket; Flush() must be called explicitly before
+	 *          the socket is released, otherwise the plain text still held
+	 *          in the write buffer is discarded (and an error is logged).
+	 */
+	virtual ~AesGcmStreamSocket()
+	{
+		if (m_asyncSend != nullptr)
+		{
+			m_asyncSend->Close();
+		}
+
+		if (m_sendBuf.size() > 0)
+		{
+			Platform::Print::StrErr(
+				"AesGcmStreamSocket - Destroyed with " +
+				std::to_string(m_sendBuf.size()) +
+				" bytes not flushed; they are discarded"
+			);
+		}
+	}
 	// LCOV_EXCL_STOP
 
 
@@ -295,7 +660,10 @@ public:
 
 
 	/**
-	 * \brief	Move assignment operator
+	 * \brief	Move assignment operator.
+	 *          Plain text still held in the write buffer of this socket is
+	 *          flushed to its current peer first; if that fails, the
+	 *          exception is thrown and neither socket is modified.
 	 *
 	 * \exception Decent::Net::Exception
 	 *
@@ -307,199 +675,1184 @@ public:
 	{
 		if (this != &other)
 		{
+			Flush();
+
 			m_rand = std::move(other.m_rand);
 			m_selfSecKey = std::move(other.m_selfSecKey);
 			m_selfMakKey = std::move(other.m_selfMakKey);
 			m_selfAddData = std::move(other.m_selfAddData);
 			m_selfAesGcm = std::move(other.m_selfAesGcm);
+			m_ivPolicy = other.m_ivPolicy;
+			m_selfIvSalt = other.m_selfIvSalt;
 			m_peerSecKey = std::move(other.m_peerSecKey);
 			m_peerMakKey = std::move(other.m_peerMakKey);
 			m_peerAddData = std::move(other.m_peerAddData);
 			m_peerAesGcm = std::move(other.m_peerAesGcm);
+			if (m_asyncSend != nullptr)
+			{
+				m_asyncSend->Close();
+			}
 			m_socket = std::move(other.m_socket);
+			m_asyncSend = std::move(other.m_asyncSend);
 			m_recvBuf = std::move(other.m_recvBuf);
+			m_recvPos = other.m_recvPos;
+			m_recvEnd = other.m_recvEnd;
+			other.m_recvPos = 0;
+			other.m_recvEnd = 0;
+			m_sendBufThreshold = other.m_sendBufThreshold;
+			m_sendBuf = std::move(other.m_sendBuf);
+			m_appWriteCount = other.m_appWriteCount;
+			m_recordSentCount = other.m_recordSentCount;
 		}
 
 		return *this;
 	}
 
 
-	virtual size_t SendRaw(const void* buf, const size_t size) override
+	/**
+	 * \brief	Sets how the IV of each record sent is generated.
+	 *          The IV is carried in every package, so the peer can decrypt
+	 *          records regardless of the policy used on this side.
+	 */
+	void SetIvPolicy(AesGcmIvPolicy ivPolicy)
 	{
-		std::vector<uint8_t> encBlock = EncryptMsg(
-			std::vector<uint8_t>(
-				static_cast<const uint8_t*>(buf),
-				static_cast<const uint8_t*>(buf) + size
-			)
-		);
+		m_ivPolicy = ivPolicy;
+	}
 
-		m_socket->SizedSendBytes<std::vector<uint8_t>, SizedSendSizeType>(
-			encBlock
-		);
+	AesGcmIvPolicy GetIvPolicy() const
+	{
+		return m_ivPolicy;
+	}
 
-		return size;
+	/**
+	 * \brief	Sets the size of the write buffer used to coalesce small
+	 *          writes into a single sealed record.
+	 *          With a threshold of 0 (the default) every call to SendRaw
+	 *          produces its own record.
+	 *          Otherwise, plain text is accumulated until the threshold is
+	 *          reached, or until Flush() is called, or until this socket
+	 *          needs to receive data from the peer.
+	 *
+	 * \param	threshold	Size of the write buffer, in bytes.
+	 */
+	void SetWriteBufferThreshold(size_t threshold)
+	{
+		Flush();
+		m_sendBufThreshold = threshold;
 	}
 
+	size_t GetWriteBufferThreshold() const
+	{
+		return m_sendBufThreshold;
+	}
 
-	virtual size_t RecvRaw(void* buf, const size_t size) override
+	/**
+	 * \brief	Seals all the plain text currently held in the write buffer
+	 *          into one record and sends it.
+	 */
+	void Flush()
 	{
-		if (m_recvBuf.size() == 0)
+		if (m_sendBuf.size() > 0)
 		{
-			//Buffer is clear, we need to poll data from remote first.
+			SendRecord(m_sendBuf.data(), m_sendBuf.size());
+			m_sendBuf.clear();
+		}
+	}
 
-			std::vector<uint8_t> encBlock =
-				m_socket->SizedRecvBytes<
-					std::vector<uint8_t>,
-					SizedSendSizeType
-				>();
+	/** \brief	Number of SendRaw calls made by the application. */
+	uint64_t GetAppWriteCount() const
+	{
+		return m_appWriteCount;
+	}
 
-			m_recvBuf = DecryptMsg(encBlock);
-		}
+	/** \brief	Number of sealed records actually sent to the peer. */
+	uint64_t GetRecordSentCount() const
+	{
+		return m_recordSentCount;
+	}
 
-		const bool isOutBufEnough = m_recvBuf.size() <= size;
-		const size_t byteToCopy = isOutBufEnough ? m_recvBuf.size() : size;
 
-		std::memcpy(buf, m_recvBuf.data(), byteToCopy);
+	/**
+	 * \brief	Sends a message as a stream of sealed chunks, each carrying at
+	 *          most sk_streamChunkSize bytes of plain text.
+	 *          The chunk index and the final chunk flag are bound into the
+	 *          additional data of each chunk, so the peer detects reordered,
+	 *          dropped or truncated chunks.
+	 *          The peer must receive it with StreamRecvBytes.
+	 *
+	 * \param 	buf 	Pointer to the message (plain text).
+	 * \param 	size	Size of the message.
+	 */
+	void StreamSendBytes(const void* buf, size_t size)
+	{
+		// anything written before must reach the peer first
+		Flush();
+
+		static constexpr size_t _chunkSize = sk_streamChunkSize;
 
-		//Clean the buffer
-		if (isOutBufEnough)
-		{
-			m_recvBuf.clear();
-		}
-		else
+		const uint8_t* bytePtr = static_cast<const uint8_t*>(buf);
+		uint64_t chunkIdx = 0;
+		bool isFinal = false;
+		do
 		{
-			m_recvBuf.erase(
-				m_recvBuf.begin(),
-				m_recvBuf.begin() + byteToCopy
+			const size_t chunkSize =
+				size > _chunkSize ? _chunkSize : size;
+			isFinal = (chunkSize == size);
+
+			const StreamAddDataType addData =
+				BuildStreamAddData(m_selfAddData, chunkIdx, isFinal);
+			SendRecord(
+				bytePtr,
+				chunkSize,
+				addData.data(),
+				sk_streamAddDataSize,
+				isFinal ? sk_streamFinalFlag : 0
 			);
-		}
 
-		return byteToCopy;
+			bytePtr += chunkSize;
+			size -= chunkSize;
+			++chunkIdx;
+		} while (!isFinal);
 	}
 
-	virtual void AsyncRecvRaw(
-		size_t buffSize,
-		typename Base::AsyncRecvCallback callback
-	) override
+	template<typename _ContainerType>
+	void StreamSendBytes(const _ContainerType& msg)
+	{
+		StreamSendBytes(msg.data(), msg.size());
+	}
+
+	/**
+	 * \brief	Receives a message sent by StreamSendBytes, handing each
+	 *          chunk to the consumer as soon as it has been authenticated.
+	 *          Only one chunk is held in memory at a time.
+	 *
+	 * \param 	consumer	Callback receiving the plain text of each chunk;
+	 *                      the pointer is only valid during the call.
+	 *
+	 * \return	Total size of the message received.
+	 */
+	size_t StreamRecvBytes(const StreamChunkConsumer& consumer)
 	{
-		if (m_recvBuf.size() > 0)
+		if (GetRecvBufAvail() > 0)
 		{
-			// the recv buffer is not empty
-			// we can use them first
-			callback(
-				std::vector<uint8_t>(
-					m_recvBuf.data(),
-					m_recvBuf.data() + m_recvBuf.size()
-				),
-				false
+			throw Exception(
+				"AesGcmStreamSocket::StreamRecvBytes - "
+				"Unread data left in the receive buffer"
 			);
-			m_recvBuf.clear();
 		}
-		else
+
+		// the peer may be waiting for what we have buffered
+		Flush();
+
+		const size_t maxPackSize =
+			m_peerAesGcm->GetPackSize(0, 0, sk_streamChunkSize);
+		mbedTLScpp::SecretVector<uint8_t> pkgBuf;
+		size_t totalSize = 0;
+		uint64_t chunkIdx = 0;
+		bool isFinal = false;
+		do
 		{
-			// the recv buffer is empty
-			// we need to poll data from remote
+			SizedSendSizeType header = 0;
+			RecvExact(&header, sizeof(header));
 
-			auto handler = AsyncRecvHandler::Create(
-				m_socket.get(),
-				[this, buffSize, callback](
-					std::vector<uint8_t> data,
-					bool hasErrorOccurred
-				)
-				{
-					if (!hasErrorOccurred)
-					{
-						auto decMsg = DecryptMsg(data);
-						if (decMsg.size() > buffSize)
-						{
-							// we received more data than needed
-
-							// save the rest of the data to the recv buffer
-							m_recvBuf.assign(
-								decMsg.data() + buffSize,
-								decMsg.data() + decMsg.size()
-							);
-
-							// callback with the data needed
-							callback(
-								std::vector<uint8_t>(
-									decMsg.data(),
-									decMsg.data() + buffSize
-								),
-								false
-							);
-						}
-						else
-						{
-							// decMsg.size() < buffSize
-							// we received less data than needed
-							callback(
-								std::vector<uint8_t>(
-									decMsg.data(),
-									decMsg.data() + decMsg.size()
-								),
-								false
-							);
-						}
-					}
-				}
-			);
-			AsyncRecvHandler::InitAsyncRecv(handler);
-		}
-	}
+			isFinal = (header & sk_streamFinalFlag) != 0;
+			const SizedSendSizeType packSize = header & (~sk_streamFinalFlag);
+			if (packSize > maxPackSize)
+			{
+				throw Exception(
+					"AesGcmStreamSocket::StreamRecvBytes - "
+					"The chunk received is too large"
+				);
+			}
+			pkgBuf.resize(static_cast<size_t>(packSize));
+			RecvExact(pkgBuf.data(), pkgBuf.size());
+
+			const StreamAddDataType addData =
+				BuildStreamAddData(m_peerAddData, chunkIdx, isFinal);
+
+			uint8_t* dataPtr = nullptr;
+			size_t dataSize = 0;
+			std::tie(dataPtr, dataSize, std::ignore, std::ignore) =
+				m_peerAesGcm->UnpackInPlace(
+					pkgBuf.data(),
+					pkgBuf.size(),
+					addData.data(),
+					sk_streamAddDataSize,
+					nullptr
+				);
+			CheckPeerKeysLifetime();
 
+			consumer(dataPtr, dataSize);
 
-protected:
+			totalSize += dataSize;
+			++chunkIdx;
+		} while (!isFinal);
 
-	/**
-	 * \brief	Decrypts a message into binary
-	 *
-	 * \param 	inMsg	Input message (cipher text).
-	 *
-	 * \return	Output message in binary (plain text).
-	 */
-	mbedTLScpp::SecretVector<uint8_t> DecryptMsg(
-		const std::vector<uint8_t>& inMsg
-	)
+		return totalSize;
+	}
+
+	template<typename _ContainerType>
+	_ContainerType StreamRecvBytes()
 	{
-		mbedTLScpp::SecretVector<uint8_t> res;
-		std::tie(res, std::ignore) = m_peerAesGcm->Unpack(
-			mbedTLScpp::CtnFullR(inMsg),
-			mbedTLScpp::CtnFullR(m_peerAddData),
-			nullptr
+		_ContainerType res;
+		StreamRecvBytes(
+			[&res](const uint8_t* data, size_t size)
+			{
+				res.insert(res.end(), data, data + size);
+			}
 		);
-
-		CheckPeerKeysLifetime();
-
 		return res;
 	}
 
+
 	/**
-	 * \brief	Encrypts a message into binary
+	 * \brief	Sends a large message as independently sealed chunks of
+	 *          sk_bulkChunkSize bytes, which are sealed concurrently by
+	 *          the calling thread and up to \c numHelpers helper jobs,
+	 *          and sent in order as soon as they are ready.
+	 *          Each chunk gets a message counter reserved in advance
+	 *          (a contiguous range starting at the current one), bound into
+	 *          its additional data together with the chunk index, so the
+	 *          peer still enforces the order of chunks.
+	 *          The peer must receive it with BulkRecvBytes.
+	 *          All the sealed chunks are held in a buffer until they are
+	 *          sent, so about twice the message size is used in memory,
+	 *          counting the plain text given.
 	 *
-	 * \exception Decent::Net::Exception
-	 *
-	 * \param 	inMsg	Input message (plain text).
-	 *
-	 * \return	Output message in binary (cipher text).
+	 * \param 	buf       	Pointer to the message (plain text).
+	 * \param 	size      	Size of the message.
+	 * \param 	executor  	Executor used to schedule the helper jobs.
+	 * \param 	numHelpers	Number of helper jobs to schedule.
 	 */
-	std::vector<uint8_t> EncryptMsg(
-		const std::vector<uint8_t>& inMsg
+	void BulkSendBytes(
+		const void* buf,
+		size_t size,
+		const BulkExecutor& executor,
+		size_t numHelpers
 	)
 	{
-		std::vector<uint8_t> res;
-		std::tie(res, std::ignore) = m_selfAesGcm->Pack(
-			mbedTLScpp::CtnFullR(mbedTLScpp::gsk_emptyCtn),
-			mbedTLScpp::CtnFullR(mbedTLScpp::gsk_emptyCtn),
-			mbedTLScpp::CtnFullR(inMsg),
-			mbedTLScpp::CtnFullR(m_selfAddData),
-			*m_rand
+		// anything written before must reach the peer first
+		Flush();
+
+		// announce the total size, so the peer can reserve the same
+		// counters and the output buffer
+		const uint64_t totalSize64 = static_cast<uint64_t>(size);
+		SendRecord(&totalSize64, sizeof(totalSize64));
+
+		const size_t chunkCount = GetBulkChunkCount(size);
+		const size_t fullPackSize =
+			m_selfAesGcm->GetPackSize(0, 0, sk_bulkChunkSize);
+		const size_t fullRecSize = sizeof(SizedSendSizeType) + fullPackSize;
+
+		const uint64_t counterBase = ReserveSelfCounters(chunkCount);
+		const AddDataType addDataBase = m_selfAddData;
+		const AesGcmIvPolicy ivPolicy = m_ivPolicy;
+		const uint64_t ivSalt = m_selfIvSalt;
+
+		const uint8_t* plainPtr = static_cast<const uint8_t*>(buf);
+		std::vector<uint8_t> records(
+			((chunkCount - 1) * fullRecSize) +
+			sizeof(SizedSendSizeType) +
+			m_selfAesGcm->GetPackSize(
+				0, 0, GetBulkChunkSize(size, chunkCount - 1)
+			)
 		);
+		uint8_t* recPtr = records.data();
+
+		auto state = std::make_shared<BulkJobState>(
+			m_selfSecKey,
+			chunkCount,
+			chunkCount, // all chunks are available right away
+			GetBulkMaxHelpers(executor, numHelpers, chunkCount),
+			[=](BulkWorkerCtx& ctx, size_t idx)
+			{
+				const size_t chunkSize = GetBulkChunkSize(size, idx);
+				CryptoPackager& packager = ctx.GetPackager();
+				const size_t packSize = packager.GetPackSize(0, 0, chunkSize);
+				const SizedSendSizeType header =
+					static_cast<SizedSendSizeType>(packSize);
 
-		CheckSelfKeysLifetime();
+				uint8_t* rec = recPtr + (idx * fullRecSize);
+				std::memcpy(rec, &header, sizeof(header));
 
-		return res;
-	}
+				const StreamAddDataType addData = BuildBulkAddData(
+					addDataBase, counterBase, idx, chunkCount
+				);
+				PackRecord(
+					packager,
+					ivPolicy,
+					ivSalt,
+					counterBase + idx,
+					ivPolicy == AesGcmIvPolicy::Random ?
+						&(ctx.GetRand()) : nullptr,
+					rec + sizeof(SizedSendSizeType),
+					packSize,
+					plainPtr + (idx * sk_bulkChunkSize), chunkSize,
+					addData.data(), sk_streamAddDataSize
+				);
+			}
+		);
+
+		BulkWorkerCtx ctx(m_selfSecKey);
+		try
+		{
+			ScheduleBulkHelpers(state, executor);
+
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				state->WaitChunk(ctx, i);
+
+				const size_t recSize = (i + 1 < chunkCount) ?
+					fullRecSize :
+					(records.size() - (i * fullRecSize));
+				SendExact(recPtr + (i * fullRecSize), recSize);
+				++m_recordSentCount;
+			}
+		}
+		catch (...)
+		{
+			state->Abort();
+			throw;
+		}
+	}
+
+	/**
+	 * \brief	Receives a message sent by BulkSendBytes.
+	 *          Chunks are verified and decrypted by the calling thread and
+	 *          up to \c numHelpers helper jobs, while the following chunks
+	 *          are still being received; helper jobs are scheduled as the
+	 *          chunks arrive, and return whenever they run out of chunks.
+	 *          The whole sealed message is received into a buffer besides
+	 *          the plain text returned, so about twice the message size is
+	 *          used in memory.
+	 *
+	 * \param 	executor  	Executor used to schedule the helper jobs.
+	 * \param 	numHelpers	Number of helper jobs to schedule.
+	 *
+	 * \return	The message received (plain text).
+	 */
+	template<typename _ContainerType>
+	_ContainerType BulkRecvBytes(
+		const BulkExecutor& executor,
+		size_t numHelpers
+	)
+	{
+		if (GetRecvBufAvail() > 0)
+		{
+			throw Exception(
+				"AesGcmStreamSocket::BulkRecvBytes - "
+				"Unread data left in the receive buffer"
+			);
+		}
+
+		// the peer may be waiting for what we have buffered
+		Flush();
+
+		uint64_t totalSize64 = 0;
+		{
+			mbedTLScpp::SecretVector<uint8_t> encBlock =
+				m_socket->SizedRecvBytes<
+					mbedTLScpp::SecretVector<uint8_t>,
+					SizedSendSizeType
+				>();
+			mbedTLScpp::SecretVector<uint8_t> sizeBlock =
+				DecryptMsgInPlace(encBlock);
+			if (sizeBlock.size() != sizeof(totalSize64))
+			{
+				throw Exception(
+					"AesGcmStreamSocket::BulkRecvBytes - "
+					"Invalid bulk transfer header"
+				);
+			}
+			std::memcpy(&totalSize64, sizeBlock.data(), sizeof(totalSize64));
+		}
+		const size_t size = static_cast<size_t>(totalSize64);
+
+		const size_t chunkCount = GetBulkChunkCount(size);
+		const size_t fullPackSize =
+			m_peerAesGcm->GetPackSize(0, 0, sk_bulkChunkSize);
+
+		const uint64_t counterBase = ReservePeerCounters(chunkCount);
+		const AddDataType addDataBase = m_peerAddData;
+
+		_ContainerType res;
+		res.resize(size);
+		uint8_t* plainPtr =
+			size == 0 ? nullptr : reinterpret_cast<uint8_t*>(&(res[0]));
+
+		mbedTLScpp::SecretVector<uint8_t> packages(
+			((chunkCount - 1) * fullPackSize) +
+			m_peerAesGcm->GetPackSize(
+				0, 0, GetBulkChunkSize(size, chunkCount - 1)
+			)
+		);
+		uint8_t* pkgPtr = packages.data();
+
+		auto state = std::make_shared<BulkJobState>(
+			m_peerSecKey,
+			chunkCount,
+			0, // chunks become available as they are received
+			GetBulkMaxHelpers(executor, numHelpers, chunkCount),
+			[=](BulkWorkerCtx& ctx, size_t idx)
+			{
+				const size_t chunkSize = GetBulkChunkSize(size, idx);
+				CryptoPackager& packager = ctx.GetPackager();
+				const size_t packSize = packager.GetPackSize(0, 0, chunkSize);
+
+				const StreamAddDataType addData = BuildBulkAddData(
+					addDataBase, counterBase, idx, chunkCount
+				);
+
+				uint8_t* dataPtr = nullptr;
+				size_t dataSize = 0;
+				std::tie(dataPtr, dataSize, std::ignore, std::ignore) =
+					packager.UnpackInPlace(
+						pkgPtr + (idx * fullPackSize),
+						packSize,
+						addData.data(),
+						sk_streamAddDataSize,
+						nullptr
+					);
+				if (dataSize != chunkSize)
+				{
+					throw Exception(
+						"AesGcmStreamSocket::BulkRecvBytes - "
+						"Invalid chunk size"
+					);
+				}
+				if (dataSize > 0)
+				{
+					std::memcpy(
+						plainPtr + (idx * sk_bulkChunkSize),
+						dataPtr,
+						dataSize
+					);
+				}
+			}
+		);
+
+		BulkWorkerCtx ctx(m_peerSecKey);
+		try
+		{
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				const size_t packSize = (i + 1 < chunkCount) ?
+					fullPackSize :
+					(packages.size() - (i * fullPackSize));
+
+				SizedSendSizeType header = 0;
+				RecvExact(&header, sizeof(header));
+				if (header != packSize)
+				{
+					throw Exception(
+						"AesGcmStreamSocket::BulkRecvBytes - "
+						"Unexpected chunk size"
+					);
+				}
+				RecvExact(pkgPtr + (i * fullPackSize), packSize);
+
+				state->AddAvailable();
+				ScheduleBulkHelpers(state, executor);
+			}
+
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				state->WaitChunk(ctx, i);
+			}
+		}
+		catch (...)
+		{
+			state->Abort();
+			throw;
+		}
+
+		return res;
+	}
+
+
+	virtual size_t SendRaw(const void* buf, const size_t size) override
+	{
+		++m_appWriteCount;
+
+		if (m_sendBufThreshold == 0)
+		{
+			SendRecord(buf, size);
+			return size;
+		}
+
+		if (m_sendBuf.size() + size > m_sendBufThreshold)
+		{
+			// the new data doesn't fit into the buffer
+			Flush();
+		}
+
+		if (size >= m_sendBufThreshold)
+		{
+			// the buffer is empty at this point,
+			// so there is no point to copy the data into it
+			SendRecord(buf, size);
+		}
+		else
+		{
+			const uint8_t* bytePtr = static_cast<const uint8_t*>(buf);
+			m_sendBuf.insert(m_sendBuf.end(), bytePtr, bytePtr + size);
+
+			if (m_sendBuf.size() >= m_sendBufThreshold)
+			{
+				Flush();
+			}
+		}
+
+		return size;
+	}
+
+
+	/**
+	 * \brief	Seals the data (together with anything held in the write
+	 *          buffer) into one record right away; the record is then sent
+	 *          asynchronously if the underlying socket supports it (see
+	 *          AsyncSend).
+	 */
+	virtual void AsyncSendRaw(
+		std::vector<uint8_t> data,
+		typename AsyncSendBase::AsyncSendCallback callback
+	) override
+	{
+		++m_appWriteCount;
+
+		std::vector<uint8_t> record;
+		try
+		{
+			const auto addDataRef = mbedTLScpp::CtnFullR(m_selfAddData);
+			if (m_sendBuf.size() > 0)
+			{
+				// what has been buffered must reach the peer first
+				m_sendBuf.insert(m_sendBuf.end(), data.begin(), data.end());
+				record = BuildRecord(
+					m_sendBuf.data(),
+					m_sendBuf.size(),
+					addDataRef.BeginBytePtr(),
+					addDataRef.GetRegionSize(),
+					0
+				);
+				m_sendBuf.clear();
+			}
+			else
+			{
+				record = BuildRecord(
+					data.data(),
+					data.size(),
+					addDataRef.BeginBytePtr(),
+					addDataRef.GetRegionSize(),
+					0
+				);
+			}
+		}
+		catch (...)
+		{
+			callback(true);
+			return;
+		}
+
+		++m_recordSentCount;
+		m_asyncSend->Push(std::move(record), std::move(callback));
+	}
+
+
+	virtual size_t RecvRaw(void* buf, const size_t size) override
+	{
+		if (GetRecvBufAvail() == 0)
+		{
+			//Buffer is clear, we need to poll data from remote first.
+			//The peer may be waiting for what we have buffered.
+			Flush();
+
+			LoadRecvRecord(
+				m_socket->SizedRecvBytes<
+					mbedTLScpp::SecretVector<uint8_t>,
+					SizedSendSizeType
+				>()
+			);
+		}
+
+		const size_t byteToCopy = ConsumeRecvBuf(buf, size);
+
+		return byteToCopy;
+	}
+
+	virtual void AsyncRecvRaw(
+		size_t buffSize,
+		typename Base::AsyncRecvCallback callback
+	) override
+	{
+		if (GetRecvBufAvail() > 0)
+		{
+			// the recv buffer is not empty
+			// we can use them first
+			callback(ConsumeRecvBuf(buffSize), false);
+		}
+		else
+		{
+			// the recv buffer is empty
+			// we need to poll data from remote
+			// (and the peer may be waiting for what we have buffered)
+			Flush();
+
+			auto handler = AsyncRecvHandler::Create(
+				m_socket.get(),
+				[this, buffSize, callback](
+					std::vector<uint8_t> data,
+					bool hasErrorOccurred
+				)
+				{
+					if (!hasErrorOccurred)
+					{
+						mbedTLScpp::SecretVector<uint8_t> encBlock;
+						encBlock.insert(encBlock.end(), data.begin(), data.end());
+						LoadRecvRecord(std::move(encBlock));
+
+						// callback with the data needed, the rest (if any)
+						// stays in the recv buffer
+						callback(ConsumeRecvBuf(buffSize), false);
+					}
+				}
+			);
+			AsyncRecvHandler::InitAsyncRecv(handler);
+		}
+	}
+
+
+protected:
+
+	/**
+	 * \brief	Decrypts a message into binary
+	 *
+	 * \param 	inMsg	Input message (cipher text).
+	 *
+	 * \return	Output message in binary (plain text).
+	 */
+	mbedTLScpp::SecretVector<uint8_t> DecryptMsg(
+		const std::vector<uint8_t>& inMsg
+	)
+	{
+		mbedTLScpp::SecretVector<uint8_t> encBlock;
+		encBlock.insert(encBlock.end(), inMsg.begin(), inMsg.end());
+
+		return DecryptMsgInPlace(encBlock);
+	}
+
+	/**
+	 * \brief	Decrypts a message in place, so the only copy made is the
+	 *          one of the plain text data out of the package.
+	 *
+	 * \param 	inMsg	Input message (cipher text); it will contain the
+	 *                  decrypted package afterwards.
+	 *
+	 * \return	Output message in binary (plain text).
+	 */
+	mbedTLScpp::SecretVector<uint8_t> DecryptMsgInPlace(
+		mbedTLScpp::SecretVector<uint8_t>& inMsg
+	)
+	{
+		uint8_t* dataPtr = nullptr;
+		size_t dataSize = 0;
+		std::tie(dataPtr, dataSize, std::ignore, std::ignore) =
+			m_peerAesGcm->UnpackInPlace(
+				inMsg.data(),
+				inMsg.size(),
+				mbedTLScpp::CtnFullR(m_peerAddData),
+				nullptr
+			);
+
+		mbedTLScpp::SecretVector<uint8_t> res;
+		res.insert(res.end(), dataPtr, dataPtr + dataSize);
+
+		CheckPeerKeysLifetime();
+
+		return res;
+	}
+
+	/**
+	 * \brief	Encrypts a message into binary
+	 *
+	 * \exception Decent::Net::Exception
+	 *
+	 * \param 	inMsg	Input message (plain text).
+	 *
+	 * \return	Output message in binary (cipher text).
+	 */
+	std::vector<uint8_t> EncryptMsg(
+		const std::vector<uint8_t>& inMsg
+	)
+	{
+		return EncryptMsg(inMsg.data(), inMsg.size());
+	}
+
+	/**
+	 * \brief	Encrypts a message into binary, sealing the plain text
+	 *          directly into the output package.
+	 *
+	 * \param 	buf 	Pointer to the input message (plain text).
+	 * \param 	size	Size of the input message.
+	 *
+	 * \return	Output message in binary (cipher text).
+	 */
+	std::vector<uint8_t> EncryptMsg(const void* buf, size_t size)
+	{
+		std::vector<uint8_t> res(m_selfAesGcm->GetPackSize(0, 0, size));
+		EncryptMsgInto(res.data(), res.size(), buf, size);
+
+		return res;
+	}
+
+	/**
+	 * \brief	Seals a message into the given output buffer.
+	 *
+	 * \param 	outBuf    	Pointer to the output buffer.
+	 * \param 	outBufSize	Size of the output buffer, which must be exactly
+	 *                      the pack size of the message.
+	 * \param 	buf       	Pointer to the input message (plain text).
+	 * \param 	size      	Size of the input message.
+	 */
+	void EncryptMsgInto(
+		void* outBuf,
+		size_t outBufSize,
+		const void* buf,
+		size_t size
+	)
+	{
+		const auto addDataRef = mbedTLScpp::CtnFullR(m_selfAddData);
+
+		EncryptMsgInto(
+			outBuf,
+			outBufSize,
+			buf,
+			size,
+			addDataRef.BeginBytePtr(),
+			addDataRef.GetRegionSize()
+		);
+	}
+
+	void EncryptMsgInto(
+		void* outBuf,
+		size_t outBufSize,
+		const void* buf,
+		size_t size,
+		const void* addData,
+		size_t addDataSize
+	)
+	{
+		PackRecord(
+			*m_selfAesGcm,
+			m_ivPolicy,
+			m_selfIvSalt,
+			m_selfAddData[2],
+			m_rand.get(),
+			outBuf,
+			outBufSize,
+			buf, size,
+			addData, addDataSize
+		);
+
+		CheckSelfKeysLifetime();
+	}
+
+	/**
+	 * \brief	Seals one record with the given packager, generating its IV
+	 *          according to the IV policy.
+	 *
+	 * \param	counter	Message counter of the record; must be the one bound
+	 *                  into its additional data.
+	 * \param	rand   	Random bit generator; only used by the random policy.
+	 */
+	static void PackRecord(
+		CryptoPackager& packager,
+		AesGcmIvPolicy ivPolicy,
+		uint64_t ivSalt,
+		uint64_t counter,
+		mbedTLScpp::RbgInterface* rand,
+		void* outBuf,
+		size_t outBufSize,
+		const void* buf,
+		size_t size,
+		const void* addData,
+		size_t addDataSize
+	)
+	{
+		if (ivPolicy == AesGcmIvPolicy::Counter)
+		{
+			IVType iv;
+			DeriveCounterIv(iv, ivSalt, counter);
+			packager.PackInto(
+				outBuf,
+				outBufSize,
+				nullptr, 0, // key meta
+				nullptr, 0, // meta
+				buf, size,
+				addData, addDataSize,
+				iv
+			);
+		}
+		else
+		{
+			packager.PackInto(
+				outBuf,
+				outBufSize,
+				nullptr, 0, // key meta
+				nullptr, 0, // meta
+				buf, size,
+				addData, addDataSize,
+				*rand
+			);
+		}
+	}
+
+	/**
+	 * \brief	Derives the IV of a record from the salt and its counter:
+	 *          IV = (salt + (counter >> 32)) || (counter & 0xFFFFFFFF).
+	 *          Each counter value maps to a distinct IV under the same salt,
+	 *          and since each direction draws its own 64-bit salt, the two
+	 *          directions (which start with the same key) won't collide.
+	 */
+	static void DeriveCounterIv(IVType& iv, uint64_t salt, uint64_t counter)
+	{
+		static_assert(sizeof(IVType) == 12, "Unexpected IV size");
+
+		const uint64_t high = salt + (counter >> 32);
+		const uint32_t low = static_cast<uint32_t>(counter);
+		std::memcpy(iv, &high, sizeof(high));
+		std::memcpy(iv + sizeof(high), &low, sizeof(low));
+	}
+
+	/**
+	 * \brief	Seals a message into one record and sends it to the peer.
+	 *          The size prefix and the record are sent with one write,
+	 *          in the same format as SizedSendBytes.
+	 *
+	 * \param 	buf 	Pointer to the input message (plain text).
+	 * \param 	size	Size of the input message.
+	 */
+	void SendRecord(const void* buf, size_t size)
+	{
+		const auto addDataRef = mbedTLScpp::CtnFullR(m_selfAddData);
+
+		SendRecord(
+			buf,
+			size,
+			addDataRef.BeginBytePtr(),
+			addDataRef.GetRegionSize(),
+			0
+		);
+	}
+
+	/**
+	 * \brief	Seals a message into one record, with the given additional
+	 *          data, and sends it to the peer.
+	 *
+	 * \param 	buf        	Pointer to the input message (plain text).
+	 * \param 	size       	Size of the input message.
+	 * \param 	addData    	Pointer to the additional data.
+	 * \param 	addDataSize	Size of the additional data.
+	 * \param 	sizeFlags  	Flags combined into the size prefix.
+	 */
+	void SendRecord(
+		const void* buf,
+		size_t size,
+		const void* addData,
+		size_t addDataSize,
+		SizedSendSizeType sizeFlags
+	)
+	{
+		std::vector<uint8_t> record =
+			BuildRecord(buf, size, addData, addDataSize, sizeFlags);
+
+		SendExact(record.data(), record.size());
+
+		++m_recordSentCount;
+	}
+
+	/**
+	 * \brief	Seals a message into one record, with the given additional
+	 *          data, in the format sent by SendRecord.
+	 */
+	std::vector<uint8_t> BuildRecord(
+		const void* buf,
+		size_t size,
+		const void* addData,
+		size_t addDataSize,
+		SizedSendSizeType sizeFlags
+	)
+	{
+		const size_t packSize = m_selfAesGcm->GetPackSize(0, 0, size);
+		const SizedSendSizeType header =
+			static_cast<SizedSendSizeType>(packSize) | sizeFlags;
+
+		std::vector<uint8_t> record(sizeof(SizedSendSizeType) + packSize);
+		std::memcpy(record.data(), &header, sizeof(SizedSendSizeType));
+		EncryptMsgInto(
+			record.data() + sizeof(SizedSendSizeType),
+			packSize,
+			buf,
+			size,
+			addData,
+			addDataSize
+		);
+
+		return record;
+	}
+
+	static std::shared_ptr<Internal::AsyncSendQueue> MakeAsyncSendQueue(
+		SocketType* sock
+	)
+	{
+		// the queue is closed before the socket is destroyed
+		return std::make_shared<Internal::AsyncSendQueue>(
+			[sock](
+				std::vector<uint8_t> data,
+				Internal::AsyncSendQueue::Callback callback
+			)
+			{
+				AsyncSend(*sock, std::move(data), std::move(callback));
+			}
+		);
+	}
+
+	/**
+	 * \brief	Sends exactly \c size bytes to the underlying socket.
+	 *          It's used by all of the blocking sends, which must not be
+	 *          made until the records of the pending async sends, sealed
+	 *          before, have reached the peer.
+	 */
+	void SendExact(const void* buf, size_t size)
+	{
+		if (!m_asyncSend->IsIdle())
+		{
+			throw Exception(
+				"AesGcmStreamSocket::SendExact - "
+				"There are async sends pending"
+			);
+		}
+
+		const uint8_t* bytePtr = static_cast<const uint8_t*>(buf);
+		size_t sentSize = 0;
+		while (sentSize < size)
+		{
+			sentSize += m_socket->SendRaw(
+				bytePtr + sentSize,
+				size - sentSize
+			);
+		}
+	}
+
+	/**
+	 * \brief	Receives exactly \c size bytes from the underlying socket.
+	 */
+	void RecvExact(void* buf, size_t size)
+	{
+		uint8_t* bytePtr = static_cast<uint8_t*>(buf);
+		size_t recvdSize = 0;
+		while (recvdSize < size)
+		{
+			const size_t got =
+				m_socket->RecvRaw(bytePtr + recvdSize, size - recvdSize);
+			if (got == 0)
+			{
+				throw Exception(
+					"AesGcmStreamSocket::RecvExact - "
+					"Connection closed by the peer"
+				);
+			}
+			recvdSize += got;
+		}
+	}
+
+	/**
+	 * \brief	Number of decrypted bytes left unread in the recv buffer.
+	 */
+	size_t GetRecvBufAvail() const
+	{
+		return m_recvEnd - m_recvPos;
+	}
+
+	/**
+	 * \brief	Decrypts a received record in place and makes it the recv
+	 *          buffer; the plain text is consumed from the package directly,
+	 *          by moving the read cursor.
+	 *
+	 * \param	encBlock	The record received (cipher text).
+	 */
+	void LoadRecvRecord(mbedTLScpp::SecretVector<uint8_t> encBlock)
+	{
+		uint8_t* dataPtr = nullptr;
+		size_t dataSize = 0;
+		std::tie(dataPtr, dataSize, std::ignore, std::ignore) =
+			m_peerAesGcm->UnpackInPlace(
+				encBlock.data(),
+				encBlock.size(),
+				mbedTLScpp::CtnFullR(m_peerAddData),
+				nullptr
+			);
+
+		CheckPeerKeysLifetime();
+
+		m_recvBuf = std::move(encBlock);
+		m_recvPos = static_cast<size_t>(dataPtr - m_recvBuf.data());
+		m_recvEnd = m_recvPos + dataSize;
+	}
+
+	/**
+	 * \brief	Copies up to \c size unread bytes out of the recv buffer and
+	 *          advances the read cursor.
+	 *
+	 * \return	Number of bytes copied.
+	 */
+	size_t ConsumeRecvBuf(void* buf, size_t size)
+	{
+		const size_t avail = GetRecvBufAvail();
+		const size_t byteToCopy = avail <= size ? avail : size;
+
+		if (byteToCopy > 0)
+		{
+			std::memcpy(buf, m_recvBuf.data() + m_recvPos, byteToCopy);
+		}
+		m_recvPos += byteToCopy;
+
+		if (m_recvPos == m_recvEnd)
+		{
+			//Clean the buffer
+			m_recvBuf.clear();
+			m_recvPos = 0;
+			m_recvEnd = 0;
+		}
+
+		return byteToCopy;
+	}
+
+	std::vector<uint8_t> ConsumeRecvBuf(size_t size)
+	{
+		const size_t avail = GetRecvBufAvail();
+		std::vector<uint8_t> res(avail <= size ? avail : size);
+		ConsumeRecvBuf(res.data(), res.size());
+		return res;
+	}
+
+	static StreamAddDataType BuildStreamAddData(
+		const AddDataType& addData,
+		uint64_t chunkIdx,
+		bool isFinal
+	)
+	{
+		StreamAddDataType res;
+		std::memcpy(
+			res.data(),
+			addData.data(),
+			sizeof(AddDataType::value_type) * AddDataType::sk_itemCount
+		);
+		res[AddDataType::sk_itemCount] = chunkIdx;
+		res[AddDataType::sk_itemCount + 1] = isFinal ? 1 : 0;
+		return res;
+	}
+
+	static StreamAddDataType BuildBulkAddData(
+		const AddDataType& addDataBase,
+		uint64_t counterBase,
+		size_t chunkIdx,
+		size_t chunkCount
+	)
+	{
+		AddDataType addData = addDataBase;
+		addData[2] = counterBase + chunkIdx;
+		return BuildStreamAddData(
+			addData,
+			static_cast<uint64_t>(chunkIdx),
+			(chunkIdx + 1) == chunkCount
+		);
+	}
+
+	static size_t GetBulkChunkCount(size_t size)
+	{
+		// an empty message is still sent as one (empty) chunk
+		return size == 0 ?
+			1 :
+			((size + (sk_bulkChunkSize - 1)) / sk_bulkChunkSize);
+	}
+
+	static size_t GetBulkChunkSize(size_t size, size_t chunkIdx)
+	{
+		const size_t offset = chunkIdx * sk_bulkChunkSize;
+		const size_t left = size - offset;
+		return left < sk_bulkChunkSize ? left : size_t(sk_bulkChunkSize);
+	}
+
+	static size_t GetBulkMaxHelpers(
+		const BulkExecutor& executor,
+		size_t numHelpers,
+		size_t chunkCount
+	)
+	{
+		if (!executor)
+		{
+			return 0;
+		}
+
+		// the calling thread works on chunks as well
+		const size_t maxHelpers = chunkCount - 1;
+		return numHelpers > maxHelpers ? maxHelpers : numHelpers;
+	}
+
+	/**
+	 * \brief	Schedules helpers for the chunks available but not claimed
+	 *          yet, as long as fewer than the maximum are running.
+	 */
+	static void ScheduleBulkHelpers(
+		std::shared_ptr<BulkJobState> state,
+		const BulkExecutor& executor
+	)
+	{
+		while (state->TryAddHelper())
+		{
+			executor(
+				[state]()
+				{
+					BulkJobState::RunHelper(state);
+				}
+			);
+		}
+	}
+
+	/**
+	 * \brief	Reserves a contiguous range of message counters on self side,
+	 *          refreshing the keys first if the range doesn't fit.
+	 *
+	 * \return	The first counter of the range.
+	 */
+	uint64_t ReserveSelfCounters(size_t count)
+	{
+		if ((sk_maxCounter - m_selfAddData[2]) < count)
+		{
+			RefreshSelfKeys();
+		}
+		const uint64_t base = m_selfAddData[2];
+		m_selfAddData[2] += count;
+		return base;
+	}
+
+	/**
+	 * \brief	Reserves a contiguous range of message counters on peer side;
+	 *          this must mirror ReserveSelfCounters.
+	 *
+	 * \return	The first counter of the range.
+	 */
+	uint64_t ReservePeerCounters(size_t count)
+	{
+		if ((sk_maxCounter - m_peerAddData[2]) < count)
+		{
+			RefreshPeerKeys();
+		}
+		const uint64_t base = m_peerAddData[2];
+		m_peerAddData[2] += count;
+		return base;
+	}
 
 	void CheckSelfKeysLifetime()
 	{
@@ -562,6 +1915,7 @@ protected:
 		RefreshSelfAesGcmer();
 
 		RefreshSelfAddData();
+		RefreshSelfIvSalt();
 	}
 
 	void RefreshPeerAesGcmer()
@@ -634,6 +1988,14 @@ private:
 		m_selfAddData[2] = 0;
 	}
 
+	/** \brief	Draws a new IV salt for the current self key.
+	 *         USED BY THE CONSTRUCTOR, CANNOT BE VIRTUAL!
+	 */
+	void RefreshSelfIvSalt()
+	{
+		m_rand->Rand(&m_selfIvSalt, sizeof(m_selfIvSalt));
+	}
+
 	/** \brief	Refresh peer add data.
 	 *         USED BY THE CONSTRUCTOR, CANNOT BE VIRTUAL!
 	 */
@@ -672,6 +2034,8 @@ private:
 	KeyType m_selfMakKey; //Masking Key
 	AddDataType m_selfAddData; //Additonal Data for MAC (m_selfMakKey || MsgCounter)
 	std::unique_ptr<CryptoPackager> m_selfAesGcm;
+	AesGcmIvPolicy m_ivPolicy;
+	uint64_t m_selfIvSalt; //Salt for counter-derived IVs (per self key)
 
 	KeyType m_peerSecKey; //Secret Key
 	KeyType m_peerMakKey; //Masking Key
@@ -679,8 +2043,20 @@ private:
 	std::unique_ptr<CryptoPackager> m_peerAesGcm;
 
 	std::unique_ptr<SocketType> m_socket;
+	std::shared_ptr<Internal::AsyncSendQueue> m_asyncSend;
 
+	/**
+	 * \brief	The last record received, decrypted in place;
+	 *          the unread plain text is in [m_recvPos, m_recvEnd)
+	 */
 	mbedTLScpp::SecretVector<uint8_t> m_recvBuf;
+	size_t m_recvPos;
+	size_t m_recvEnd;
+
+	size_t m_sendBufThreshold;
+	mbedTLScpp::SecretVector<uint8_t> m_sendBuf;
+	uint64_t m_appWriteCount;
+	uint64_t m_recordSentCount;
 }; // class AesGcmStreamSocket
 
 
@@ -0,0 +1,295 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <SimpleSysIO/StreamSocketBase.hpp>
+
+#include "Internal/SimpleSysIO.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Common
+{
+
+
+/**
+ * \brief Interface of the stream sockets that can send asynchronously;
+ *        it's implemented next to `StreamSocketBase`, which only has the
+ *        blocking send.
+ */
+class AsyncSendSocketIntf
+{
+public: // static members:
+
+	/**
+	 * \brief Called once the data has been handed to the underlying
+	 *        transport entirely (false), or the send has failed (true).
+	 */
+	using AsyncSendCallback = std::function<void(bool)>;
+
+public:
+
+	AsyncSendSocketIntf() = default;
+
+	// LCOV_EXCL_START
+	virtual ~AsyncSendSocketIntf() = default;
+	// LCOV_EXCL_STOP
+
+	/**
+	 * \brief Send all of the given data, without blocking the caller until
+	 *        the peer has accepted it. Data given to consecutive calls is
+	 *        sent in order; the blocking `SendRaw` must not be used until
+	 *        all of the pending async sends have completed.
+	 *        The callback may be called before this function returns.
+	 */
+	virtual void AsyncSendRaw(
+		std::vector<uint8_t> data,
+		AsyncSendCallback callback
+	) = 0;
+
+}; // class AsyncSendSocketIntf
+
+
+/**
+ * \brief Send the data asynchronously if the socket supports it;
+ *        otherwise, it's sent in a blocking way, and the callback is
+ *        called before this function returns.
+ */
+inline void AsyncSend(
+	Internal::SysIO::StreamSocketBase& socket,
+	std::vector<uint8_t> data,
+	AsyncSendSocketIntf::AsyncSendCallback callback
+)
+{
+	AsyncSendSocketIntf* asyncSocket =
+		dynamic_cast<AsyncSendSocketIntf*>(&socket);
+	if (asyncSocket != nullptr)
+	{
+		asyncSocket->AsyncSendRaw(std::move(data), std::move(callback));
+		return;
+	}
+
+	bool hasErrorOccurred = false;
+	try
+	{
+		size_t sentSize = 0;
+		while (sentSize < data.size())
+		{
+			sentSize += Internal::SysIO::StreamSocketRaw::Send(
+				socket,
+				data.data() + sentSize,
+				data.size() - sentSize
+			);
+		}
+	}
+	catch (...)
+	{
+		hasErrorOccurred = true;
+	}
+	callback(hasErrorOccurred);
+}
+
+
+namespace Internal
+{
+
+
+/**
+ * \brief Queue of the async sends of a socket; only one send is handed to
+ *        the transport at a time, so the data arrives in order. Like the
+ *        async receive of `TlsSocket`, it's driven by a loop, so sends
+ *        completing synchronously don't grow the stack.
+ */
+class AsyncSendQueue :
+	public std::enable_shared_from_this<AsyncSendQueue>
+{
+public: // static members:
+
+	using Callback = AsyncSendSocketIntf::AsyncSendCallback;
+
+	/**
+	 * \brief Hands the data to the transport; it must either call the
+	 *        given callback exactly once (possibly before returning), or
+	 *        throw without calling it.
+	 */
+	using IssueFunc = std::function<void(std::vector<uint8_t>, Callback)>;
+
+public:
+
+	AsyncSendQueue(IssueFunc issueFunc) :
+		m_issueFunc(std::move(issueFunc)),
+		m_mutex(),
+		m_issueCond(),
+		m_items(),
+		m_isRunning(false),
+		m_isIssuing(false),
+		m_isSending(false),
+		m_hasDone(false),
+		m_doneHasError(false),
+		m_isClosed(false)
+	{}
+
+	~AsyncSendQueue() = default;
+
+	void Push(std::vector<uint8_t> data, Callback callback)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_items.emplace_back(Item{ std::move(data), std::move(callback) });
+		RunIfIdle(lock);
+	}
+
+	/**
+	 * \brief Stop handing data to the transport (e.g., because the socket
+	 *        is being destroyed); the sends not handed over yet fail, once
+	 *        the one in progress (if any) is done.
+	 *        It returns once no send is being handed over.
+	 */
+	void Close()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_isClosed = true;
+		m_issueCond.wait(lock, [this](){ return !m_isIssuing; });
+		RunIfIdle(lock);
+	}
+
+	/**
+	 * \brief Whether there is no send pending.
+	 */
+	bool IsIdle() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_items.empty();
+	}
+
+private:
+
+	struct Item
+	{
+		std::vector<uint8_t> m_data;
+		Callback m_callback;
+	}; // struct Item
+
+	void OnSent(bool hasErrorOccurred)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_hasDone = true;
+		m_doneHasError = hasErrorOccurred;
+		RunIfIdle(lock);
+	}
+
+	void RunIfIdle(std::unique_lock<std::mutex>& lock)
+	{
+		if (m_isRunning)
+		{
+			// it will be picked up by the running loop
+			return;
+		}
+		m_isRunning = true;
+		Run(lock);
+	}
+
+	void Run(std::unique_lock<std::mutex>& lock)
+	{
+		while (true)
+		{
+			if (m_hasDone)
+			{
+				// the send at the front is done
+				m_hasDone = false;
+				m_isSending = false;
+				const bool hasError = m_doneHasError;
+				Callback callback = std::move(m_items.front().m_callback);
+				m_items.pop_front();
+
+				lock.unlock();
+				callback(hasError);
+				lock.lock();
+				continue;
+			}
+
+			if (m_isSending || m_items.empty())
+			{
+				// wait for the transport, or for more data
+				m_isRunning = false;
+				return;
+			}
+
+			if (m_isClosed)
+			{
+				Callback callback = std::move(m_items.front().m_callback);
+				m_items.pop_front();
+
+				lock.unlock();
+				callback(true);
+				lock.lock();
+				continue;
+			}
+
+			m_isSending = true;
+			m_isIssuing = true;
+			std::vector<uint8_t> data = std::move(m_items.front().m_data);
+			lock.unlock();
+
+			std::shared_ptr<AsyncSendQueue> self = shared_from_this();
+			bool isIssued = true;
+			try
+			{
+				m_issueFunc(
+					std::move(data),
+					[self](bool hasErrorOccurred)
+					{
+						self->OnSent(hasErrorOccurred);
+					}
+				);
+			}
+			catch (...)
+			{
+				isIssued = false;
+			}
+
+			lock.lock();
+			m_isIssuing = false;
+			m_issueCond.notify_all();
+			if (!isIssued)
+			{
+				m_hasDone = true;
+				m_doneHasError = true;
+			}
+		}
+	}
+
+	IssueFunc m_issueFunc;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_issueCond;
+	std::deque<Item> m_items;
+	bool m_isRunning;
+	bool m_isIssuing;
+	bool m_isSending;
+	bool m_hasDone;
+	bool m_doneHasError;
+	bool m_isClosed;
+
+}; // class AsyncSendQueue
+
+
+} // namespace Internal
+
+
+} // namespace Common
+} // namespace DecentEnclave
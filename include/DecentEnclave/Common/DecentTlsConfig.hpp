@@ -9,13 +9,21 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include <mbedTLScpp/TlsConfig.hpp>
 #include <SimpleObjects/Internal/make_unique.hpp>
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3) && !defined(DECENTENCLAVE_TLS_NO_1_3)
+#include <psa/crypto.h>
+#endif // MBEDTLS_SSL_PROTO_TLS1_3 && !DECENTENCLAVE_TLS_NO_1_3
 
 #include "CertStore.hpp"
+#include "DecentTlsPolicy.hpp"
 #include "Exceptions.hpp"
 #include "Internal/SimpleObj.hpp"
 #include "Keyring.hpp"
@@ -35,17 +43,108 @@ class DecentTlsConfig :
 public: // static members:
 
 	using Base = mbedTLScpp::TlsConfig;
+	using PolicyPtrType = std::shared_ptr<const DecentTlsPolicy>;
 
+	/**
+	 * \param policy The cipher suites, groups and signature algorithms to
+	 *               use; `nullptr` keeps mbedTLS's defaults.
+	 */
 	static std::shared_ptr<DecentTlsConfig>
 	MakeTlsConfig(
 		bool isServer,
 		const std::string& keyName,
-		const std::string& certName
+		const std::string& certName,
+		std::shared_ptr<mbedTLScpp::TlsSessTktMgrIntf> ticketMgr = nullptr,
+		PolicyPtrType policy = nullptr
+	)
+	{
+		return BuildTlsConfig(
+			isServer,
+			keyName,
+			CertStore::GetInstance()[certName].GetCertBase(),
+			std::move(ticketMgr),
+			std::move(policy)
+		);
+	}
+
+	/**
+	 * \brief Same as `MakeTlsConfig`, but the config is built once per
+	 *        (role, key name, cert name) and then shared by every call.
+	 *        Once the cert is replaced (i.e., `DecentCert_*::Update`), the
+	 *        next call builds a new config and replaces the cached one;
+	 *        connections still using the old config keep their snapshot.
+	 */
+	static std::shared_ptr<DecentTlsConfig>
+	GetCachedTlsConfig(
+		bool isServer,
+		const std::string& keyName,
+		const std::string& certName,
+		std::shared_ptr<mbedTLScpp::TlsSessTktMgrIntf> ticketMgr = nullptr,
+		PolicyPtrType policy = nullptr
 	)
 	{
-		auto key = Keyring::GetInstance()[keyName].GetPkeyPtr();
 		auto cert = CertStore::GetInstance()[certName].GetCertBase();
 
+		ConfigCache& cache = GetConfigCache();
+		std::lock_guard<std::mutex> lock(cache.m_mutex);
+
+		ConfigCacheEntry& entry =
+			cache.m_entries[std::make_tuple(isServer, keyName, certName)];
+		if (
+			(entry.m_config == nullptr) ||
+			(entry.m_cert != cert) ||
+			(entry.m_ticketMgr != ticketMgr) ||
+			(entry.m_policy != policy)
+		)
+		{
+			entry.m_config =
+				BuildTlsConfig(isServer, keyName, cert, ticketMgr, policy);
+			entry.m_cert = std::move(cert);
+			entry.m_ticketMgr = std::move(ticketMgr);
+			entry.m_policy = std::move(policy);
+		}
+
+		return entry.m_config;
+	}
+
+private: // static members:
+
+	using CertPtrType = std::shared_ptr<const mbedTLScpp::X509Cert>;
+
+	struct ConfigCacheEntry
+	{
+		std::shared_ptr<DecentTlsConfig> m_config;
+		CertPtrType m_cert;
+		std::shared_ptr<mbedTLScpp::TlsSessTktMgrIntf> m_ticketMgr;
+		PolicyPtrType m_policy;
+	}; // struct ConfigCacheEntry
+
+	struct ConfigCache
+	{
+		std::mutex m_mutex;
+		std::map<
+			std::tuple<bool, std::string, std::string>,
+			ConfigCacheEntry
+		> m_entries;
+	}; // struct ConfigCache
+
+	static ConfigCache& GetConfigCache()
+	{
+		static ConfigCache s_cache;
+		return s_cache;
+	}
+
+	static std::shared_ptr<DecentTlsConfig>
+	BuildTlsConfig(
+		bool isServer,
+		const std::string& keyName,
+		CertPtrType cert,
+		std::shared_ptr<mbedTLScpp::TlsSessTktMgrIntf> ticketMgr,
+		PolicyPtrType policy
+	)
+	{
+		auto key = Keyring::GetInstance()[keyName].GetPkeyPtr();
+
 		return std::make_shared<DecentTlsConfig>(
 			true, isServer, false, /* no verification for now (TODO) */
 			MBEDTLS_SSL_PRESET_DEFAULT,
@@ -54,7 +153,8 @@ public: // static members:
 			cert,
 			key,
 			Internal::Obj::Internal::make_unique<Platform::RandGenerator>(),
-			nullptr
+			std::move(ticketMgr),
+			std::move(policy)
 		);
 	}
 
@@ -68,7 +168,8 @@ public:
 		std::shared_ptr<const mbedTLScpp::X509Cert> cert,
 		std::shared_ptr<const mbedTLScpp::PKeyBase<> > prvKey,
 		std::unique_ptr<mbedTLScpp::RbgInterface> rand,
-		std::shared_ptr<mbedTLScpp::TlsSessTktMgrIntf> ticketMgr
+		std::shared_ptr<mbedTLScpp::TlsSessTktMgrIntf> ticketMgr,
+		PolicyPtrType policy = nullptr
 	) :
 		Base(
 			isStream, isServer, vrfyPeer,
@@ -80,8 +181,32 @@ public:
 			std::move(rand),
 			ticketMgr,
 			mbedTLScpp::TlsVersion::Tls1_2
-		)
-	{}
+		),
+		m_cipherSuites(),
+		m_groups(),
+		m_sigAlgs()
+	{
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3) && !defined(DECENTENCLAVE_TLS_NO_1_3)
+		// the TLS 1.3 stack of mbedTLS runs on PSA Crypto
+		InitPsaCrypto();
+
+		// TLS 1.2 is the minimum, but TLS 1.3 is negotiated whenever
+		// both peers support it; resumption by tickets is only allowed with
+		// a fresh (EC)DHE exchange, so the sessions keep forward secrecy
+		mbedtls_ssl_conf_min_tls_version(Get(), MBEDTLS_SSL_VERSION_TLS1_2);
+		mbedtls_ssl_conf_max_tls_version(Get(), MBEDTLS_SSL_VERSION_TLS1_3);
+		mbedtls_ssl_conf_tls13_key_exchange_modes(
+			Get(),
+			MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_PSK_EPHEMERAL |
+				MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_EPHEMERAL
+		);
+#endif // MBEDTLS_SSL_PROTO_TLS1_3 && !DECENTENCLAVE_TLS_NO_1_3
+
+		if (policy != nullptr)
+		{
+			ApplyPolicy(*policy);
+		}
+	}
 
 
 	virtual int CustomVerifyCert(
@@ -97,8 +222,67 @@ public:
 	}
 
 
+private: // static members:
+
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3) && !defined(DECENTENCLAVE_TLS_NO_1_3)
+	/**
+	 * \brief Initialize PSA Crypto once for the process (enclave).
+	 */
+	static void InitPsaCrypto()
+	{
+		static const psa_status_t status = psa_crypto_init();
+		if (status != PSA_SUCCESS)
+		{
+			throw Exception(
+				"DecentTlsConfig - Failed to initialize PSA Crypto (" +
+				std::to_string(static_cast<int>(status)) + ")"
+			);
+		}
+	}
+#endif // MBEDTLS_SSL_PROTO_TLS1_3 && !DECENTENCLAVE_TLS_NO_1_3
+
+
 private:
 
+	/**
+	 * \brief mbedTLS keeps pointers to the lists, so the (terminated)
+	 *        copies are kept by this config.
+	 */
+	void ApplyPolicy(const DecentTlsPolicy& policy)
+	{
+		if (!policy.m_cipherSuites.empty())
+		{
+			m_cipherSuites = policy.m_cipherSuites;
+			m_cipherSuites.push_back(0);
+			mbedtls_ssl_conf_ciphersuites(Get(), m_cipherSuites.data());
+		}
+
+		if (!policy.m_groups.empty())
+		{
+			m_groups = policy.m_groups;
+			m_groups.push_back(MBEDTLS_SSL_IANA_TLS_GROUP_NONE);
+			mbedtls_ssl_conf_groups(Get(), m_groups.data());
+		}
+
+		if (!policy.m_sigAlgs.empty())
+		{
+#if defined(MBEDTLS_SSL_HANDSHAKE_WITH_CERT_ENABLED)
+			m_sigAlgs = policy.m_sigAlgs;
+			m_sigAlgs.push_back(MBEDTLS_TLS1_3_SIG_NONE);
+			mbedtls_ssl_conf_sig_algs(Get(), m_sigAlgs.data());
+#else // MBEDTLS_SSL_HANDSHAKE_WITH_CERT_ENABLED
+			throw Exception(
+				"DecentTlsConfig::ApplyPolicy - "
+				"Signature algorithms are not configurable in this build"
+			);
+#endif // MBEDTLS_SSL_HANDSHAKE_WITH_CERT_ENABLED
+		}
+	}
+
+	std::vector<int> m_cipherSuites;
+	std::vector<uint16_t> m_groups;
+	std::vector<uint16_t> m_sigAlgs;
+
 
 }; // class DecentTlsConfig
 
@@ -0,0 +1,104 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include <mbedtls/ssl.h>
+#include <mbedtls/ssl_ciphersuites.h>
+
+
+namespace DecentEnclave
+{
+namespace Common
+{
+
+
+/**
+ * \brief Which cipher suites, key exchange groups and signature algorithms
+ *        a `DecentTlsConfig` offers (or accepts), in the order of
+ *        preference. An empty list keeps mbedTLS's default for that list.
+ */
+struct DecentTlsPolicy
+{
+	/**
+	 * \brief A policy keeping all of mbedTLS's defaults.
+	 */
+	static std::shared_ptr<const DecentTlsPolicy> GetDefault()
+	{
+		static const std::shared_ptr<const DecentTlsPolicy> sk_policy =
+			std::make_shared<DecentTlsPolicy>();
+		return sk_policy;
+	}
+
+	/**
+	 * \brief A policy for the traffic between Decent enclaves, whose
+	 *        certificates are all ECDSA on P-256: AES-128-GCM only, and
+	 *        X25519 or P-256 for the key exchange.
+	 *        It's the default of the lambda servers (`LambdaServerConfig`)
+	 *        and clients (`GetLambdaCltTlsConfig`).
+	 */
+	static std::shared_ptr<const DecentTlsPolicy> GetEnclaveToEnclave()
+	{
+		static const std::shared_ptr<const DecentTlsPolicy> sk_policy =
+			std::make_shared<DecentTlsPolicy>(
+				std::vector<int>{
+					MBEDTLS_TLS1_3_AES_128_GCM_SHA256,
+					MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+				},
+				std::vector<uint16_t>{
+					MBEDTLS_SSL_IANA_TLS_GROUP_X25519,
+					MBEDTLS_SSL_IANA_TLS_GROUP_SECP256R1,
+				},
+				std::vector<uint16_t>{
+					MBEDTLS_TLS1_3_SIG_ECDSA_SECP256R1_SHA256,
+				}
+			);
+		return sk_policy;
+	}
+
+	DecentTlsPolicy() :
+		m_cipherSuites(),
+		m_groups(),
+		m_sigAlgs()
+	{}
+
+	DecentTlsPolicy(
+		std::vector<int> cipherSuites,
+		std::vector<uint16_t> groups,
+		std::vector<uint16_t> sigAlgs
+	) :
+		m_cipherSuites(std::move(cipherSuites)),
+		m_groups(std::move(groups)),
+		m_sigAlgs(std::move(sigAlgs))
+	{}
+
+	~DecentTlsPolicy() = default;
+
+	/**
+	 * \brief Cipher suite IDs (e.g., `MBEDTLS_TLS1_3_AES_128_GCM_SHA256`).
+	 */
+	std::vector<int> m_cipherSuites;
+
+	/**
+	 * \brief Key exchange groups (e.g., `MBEDTLS_SSL_IANA_TLS_GROUP_X25519`).
+	 */
+	std::vector<uint16_t> m_groups;
+
+	/**
+	 * \brief Signature algorithms
+	 *        (e.g., `MBEDTLS_TLS1_3_SIG_ECDSA_SECP256R1_SHA256`).
+	 */
+	std::vector<uint16_t> m_sigAlgs;
+}; // struct DecentTlsPolicy
+
+
+} // namespace Common
+} // namespace DecentEnclave
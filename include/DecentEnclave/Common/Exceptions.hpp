@@ -54,5 +54,43 @@ public:
 }; // class InvalidArgumentException
 
 
+class TimeoutException : public Exception
+{
+public: // static members:
+
+	using Base = Exception;
+
+public:
+
+	using Base::Base;
+
+	// LCOV_EXCL_START
+	virtual ~TimeoutException() = default;
+	// LCOV_EXCL_STOP
+
+}; // class TimeoutException
+
+
+/**
+ * @brief The peer has closed the connection in an orderly way
+ *
+ */
+class ConnectionClosedException : public Exception
+{
+public: // static members:
+
+	using Base = Exception;
+
+public:
+
+	using Base::Base;
+
+	// LCOV_EXCL_START
+	virtual ~ConnectionClosedException() = default;
+	// LCOV_EXCL_STOP
+
+}; // class ConnectionClosedException
+
+
 } // namespace Common
 } // namespace DecentEnclave
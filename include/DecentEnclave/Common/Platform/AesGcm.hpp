@@ -7,20 +7,28 @@
 
 
 #include <array>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <mbedTLScpp/Container.hpp>
+#include <mbedTLScpp/Gcm.hpp>
 #include <mbedTLScpp/SecretVector.hpp>
 #include <mbedTLScpp/SKey.hpp>
+#include <mbedtls/platform_util.h>
 
 #ifdef DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
 #include <sgx_tcrypto.h>
 #include "../Sgx/Exceptions.hpp"
-#else
-#include <mbedTLScpp/Gcm.hpp>
 #endif // DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
 
+#include "AesGcmHwCore.hpp"
+#include "AesGcmKat.hpp"
+
 
 namespace DecentEnclave
 {
@@ -29,11 +37,343 @@ namespace Common
 namespace Platform
 {
 
+
+/**
+ * \brief A segment of additional authenticated data, in the form of
+ *        (pointer, size).
+ */
+using AesGcmAadSegment = std::pair<const void*, size_t>;
+using AesGcmAadSegList = std::initializer_list<AesGcmAadSegment>;
+
+/**
+ * \brief AES-GCM implementation backed by mbedTLS. The GCM context, which
+ *        holds the expanded AES key schedule and the GHASH table, is
+ *        initialized once at construction, and then is reused by every
+ *        message encrypted or decrypted with this instance, so only the
+ *        IV and AAD processing are paid per message.
+ *        This implementation is available on all platforms; inside SGX
+ *        enclaves, it's only used by the packagers when
+ *        `DECENTENCLAVE_AESGCM_STATEFUL` is defined (see
+ *        `AesGcmSessionNative`).
+ *
+ * \tparam _keyBitSize Size of the key, in bits.
+ */
 template<size_t _keyBitSize>
-class AesGcmOneGoNative;
+class AesGcmStateful
+{
+public: // static members:
+
+	static constexpr size_t sk_keyBitSize = _keyBitSize;
+	static constexpr size_t sk_keyByteSize = sk_keyBitSize / 8;
+
+	using KeyType = mbedTLScpp::SKey<sk_keyBitSize>;
+
+	using GcmCryptorType =
+		mbedTLScpp::Gcm<mbedTLScpp::CipherType::AES, sk_keyBitSize>;
+
+public:
+
+	AesGcmStateful(KeyType key) :
+		m_cryptor(mbedTLScpp::CtnFullR(key))
+	{}
+
+	AesGcmStateful(const AesGcmStateful& other) :
+		m_cryptor(other.m_cryptor)
+	{}
+
+	AesGcmStateful(AesGcmStateful&& other) :
+		m_cryptor(std::move(other.m_cryptor))
+	{}
+
+	~AesGcmStateful() = default;
+
+	template<
+		typename _IvCtnType,   bool _IvCtnSecrecy,
+		typename _AadCtnType,  bool _AadCtnSecrecy,
+		typename _DataCtnType, bool _DataCtnSecrecy
+	>
+	std::pair<
+		std::vector<uint8_t>,
+		std::array<uint8_t, 16>
+	>
+	Encrypt(
+		const mbedTLScpp::ContCtnReadOnlyRef<_IvCtnType,   _IvCtnSecrecy>& iv,
+		const mbedTLScpp::ContCtnReadOnlyRef<_AadCtnType,  _AadCtnSecrecy>& aad,
+		const mbedTLScpp::ContCtnReadOnlyRef<_DataCtnType, _DataCtnSecrecy>& data
+	)
+	{
+		return m_cryptor.Encrypt(
+			data,
+			iv,
+			aad
+		);
+	}
+
+	template<
+		typename _IvCtnType,   bool _IvCtnSecrecy,
+		typename _AadCtnType,  bool _AadCtnSecrecy,
+		typename _DataCtnType, bool _DataCtnSecrecy,
+		typename _TagCtnType,  bool _TagCtnSecrecy
+	>
+	mbedTLScpp::SecretVector<uint8_t>
+	Decrypt(
+		const mbedTLScpp::ContCtnReadOnlyRef<_IvCtnType,   _IvCtnSecrecy>& iv,
+		const mbedTLScpp::ContCtnReadOnlyRef<_AadCtnType,  _AadCtnSecrecy>& aad,
+		const mbedTLScpp::ContCtnReadOnlyRef<_DataCtnType, _DataCtnSecrecy>& data,
+		const mbedTLScpp::ContCtnReadOnlyRef<_TagCtnType, _TagCtnSecrecy>& tag
+	)
+	{
+		return m_cryptor.Decrypt(
+			data,
+			iv,
+			aad,
+			tag
+		);
+	}
+
+	/**
+	 * \brief Encrypt the given data in place, so that no extra buffer is
+	 *        needed for the cipher text.
+	 *
+	 * \param iv      Pointer to the IV.
+	 * \param ivSize  Size of the IV.
+	 * \param aad     Pointer to the additional authenticated data.
+	 * \param aadSize Size of the additional authenticated data.
+	 * \param data    Pointer to the plain text, which will be overwritten by
+	 *                the cipher text.
+	 * \param size    Size of the data, in bytes.
+	 *
+	 * \return The tag/MAC.
+	 */
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size
+	)
+	{
+		std::array<uint8_t, 16> tag;
+
+		// mbedTLS allows the input and output buffers to be the same
+		int mbedRet = mbedtls_gcm_crypt_and_tag(
+			m_cryptor.Get(),
+			MBEDTLS_GCM_ENCRYPT,
+			size,
+			static_cast<const unsigned char*>(iv),
+			ivSize,
+			static_cast<const unsigned char*>(aad),
+			aadSize,
+			static_cast<const unsigned char*>(data),
+			static_cast<unsigned char*>(data),
+			tag.size(),
+			tag.data()
+		);
+		mbedTLScpp::CheckMbedTlsIntRetVal(
+			mbedRet,
+			"mbedtls_gcm_crypt_and_tag",
+			"DecentEnclave::Common::Platform::AesGcmStateful::EncryptInPlace"
+		);
+
+		return tag;
+	}
+
+	/**
+	 * \brief Decrypt the given data in place.
+	 *        If the authentication fails, an exception is thrown, and the
+	 *        content of the data buffer should be discarded.
+	 *
+	 * \param iv      Pointer to the IV.
+	 * \param ivSize  Size of the IV.
+	 * \param aad     Pointer to the additional authenticated data.
+	 * \param aadSize Size of the additional authenticated data.
+	 * \param data    Pointer to the cipher text, which will be overwritten by
+	 *                the plain text.
+	 * \param size    Size of the data, in bytes.
+	 * \param tag     Pointer to the 16-byte tag/MAC.
+	 */
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		int mbedRet = mbedtls_gcm_auth_decrypt(
+			m_cryptor.Get(),
+			size,
+			static_cast<const unsigned char*>(iv),
+			ivSize,
+			static_cast<const unsigned char*>(aad),
+			aadSize,
+			static_cast<const unsigned char*>(tag),
+			16,
+			static_cast<const unsigned char*>(data),
+			static_cast<unsigned char*>(data)
+		);
+		mbedTLScpp::CheckMbedTlsIntRetVal(
+			mbedRet,
+			"mbedtls_gcm_auth_decrypt",
+			"DecentEnclave::Common::Platform::AesGcmStateful::DecryptInPlace"
+		);
+	}
+
+	/**
+	 * \brief Same as the `EncryptInPlace` above, but the additional
+	 *        authenticated data is given as a list of segments, which are
+	 *        authenticated as if they were concatenated in order.
+	 */
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size
+	)
+	{
+		std::array<uint8_t, 16> tag;
+
+		StartWithSegments(MBEDTLS_GCM_ENCRYPT, iv, ivSize, aadSegs);
+		FinishInPlace(data, size, tag.data(), tag.size());
+
+		return tag;
+	}
+
+	/**
+	 * \brief Same as the `DecryptInPlace` above, but the additional
+	 *        authenticated data is given as a list of segments, which are
+	 *        authenticated as if they were concatenated in order.
+	 */
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		std::array<uint8_t, 16> calcTag;
+
+		StartWithSegments(MBEDTLS_GCM_DECRYPT, iv, ivSize, aadSegs);
+		FinishInPlace(data, size, calcTag.data(), calcTag.size());
+
+		// constant time comparison
+		const uint8_t* tagPtr = static_cast<const uint8_t*>(tag);
+		uint8_t diff = 0;
+		for (size_t i = 0; i < calcTag.size(); ++i)
+		{
+			diff |= (calcTag[i] ^ tagPtr[i]);
+		}
+		if (diff != 0)
+		{
+			// don't leave unauthenticated plain text in the buffer
+			mbedtls_platform_zeroize(data, size);
+			mbedTLScpp::CheckMbedTlsIntRetVal(
+				MBEDTLS_ERR_GCM_AUTH_FAILED,
+				"mbedtls_gcm_finish",
+				"DecentEnclave::Common::Platform::AesGcmStateful::DecryptInPlace"
+			);
+		}
+	}
+
+private:
+
+	void StartWithSegments(
+		int mode,
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs
+	)
+	{
+		int mbedRet = mbedtls_gcm_starts(
+			m_cryptor.Get(),
+			mode,
+			static_cast<const unsigned char*>(iv),
+			ivSize
+		);
+		mbedTLScpp::CheckMbedTlsIntRetVal(
+			mbedRet,
+			"mbedtls_gcm_starts",
+			"DecentEnclave::Common::Platform::AesGcmStateful::StartWithSegments"
+		);
+
+		// each segment is fed into GHASH directly, without concatenation
+		for (const AesGcmAadSegment& seg : aadSegs)
+		{
+			if (seg.second == 0)
+			{
+				continue;
+			}
+			mbedRet = mbedtls_gcm_update_ad(
+				m_cryptor.Get(),
+				static_cast<const unsigned char*>(seg.first),
+				seg.second
+			);
+			mbedTLScpp::CheckMbedTlsIntRetVal(
+				mbedRet,
+				"mbedtls_gcm_update_ad",
+				"DecentEnclave::Common::Platform::AesGcmStateful::StartWithSegments"
+			);
+		}
+	}
+
+	void FinishInPlace(
+		void* data,
+		size_t size,
+		unsigned char* tag,
+		size_t tagSize
+	)
+	{
+		size_t outLen = 0;
+		int mbedRet = mbedtls_gcm_update(
+			m_cryptor.Get(),
+			static_cast<const unsigned char*>(data),
+			size,
+			static_cast<unsigned char*>(data),
+			size,
+			&outLen
+		);
+		mbedTLScpp::CheckMbedTlsIntRetVal(
+			mbedRet,
+			"mbedtls_gcm_update",
+			"DecentEnclave::Common::Platform::AesGcmStateful::FinishInPlace"
+		);
+
+		// GCM is a stream mode, so there is nothing left to output
+		mbedRet = mbedtls_gcm_finish(
+			m_cryptor.Get(),
+			nullptr,
+			0,
+			&outLen,
+			tag,
+			tagSize
+		);
+		mbedTLScpp::CheckMbedTlsIntRetVal(
+			mbedRet,
+			"mbedtls_gcm_finish",
+			"DecentEnclave::Common::Platform::AesGcmStateful::FinishInPlace"
+		);
+	}
+
+	GcmCryptorType m_cryptor;
+
+}; // class AesGcmStateful
+
 
 #ifdef DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
 
+template<size_t _keyBitSize>
+class AesGcmOneGoNative;
+
+/**
+ * \brief AES-GCM implementation backed by the SGX SDK. Every call hands the
+ *        raw key to the SDK, so the key schedule is expanded per message.
+ */
 template<>
 class AesGcmOneGoNative<128>
 {
@@ -142,6 +482,208 @@ public:
 		return res;
 	}
 
+	/**
+	 * \brief Encrypt the given data in place, so that no extra buffer is
+	 *        needed for the cipher text.
+	 *
+	 * \param iv      Pointer to the IV.
+	 * \param ivSize  Size of the IV.
+	 * \param aad     Pointer to the additional authenticated data.
+	 * \param aadSize Size of the additional authenticated data.
+	 * \param data    Pointer to the plain text, which will be overwritten by
+	 *                the cipher text.
+	 * \param size    Size of the data, in bytes.
+	 *
+	 * \return The tag/MAC.
+	 */
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size
+	)
+	{
+		std::array<uint8_t, 16> tag;
+
+		const sgx_aes_gcm_128bit_key_t* keyPtr =
+			reinterpret_cast<const sgx_aes_gcm_128bit_key_t*>(m_key.data());
+		sgx_aes_gcm_128bit_tag_t* tagPtr =
+			reinterpret_cast<sgx_aes_gcm_128bit_tag_t*>(tag.data());
+
+		sgx_status_t sgxRet = sgx_rijndael128GCM_encrypt(
+			keyPtr,
+			static_cast<const uint8_t*>(data),
+			static_cast<uint32_t>(size),
+			static_cast<uint8_t*>(data),
+			static_cast<const uint8_t*>(iv),
+			static_cast<uint32_t>(ivSize),
+			static_cast<const uint8_t*>(aad),
+			static_cast<uint32_t>(aadSize),
+			tagPtr
+		);
+		DECENTENCLAVE_CHECK_SGX_RUNTIME_ERROR(
+			sgxRet,
+			sgx_rijndael128GCM_encrypt
+		);
+
+		return tag;
+	}
+
+	/**
+	 * \brief Decrypt the given data in place.
+	 *        If the authentication fails, an exception is thrown, and the
+	 *        content of the data buffer should be discarded.
+	 *
+	 * \param iv      Pointer to the IV.
+	 * \param ivSize  Size of the IV.
+	 * \param aad     Pointer to the additional authenticated data.
+	 * \param aadSize Size of the additional authenticated data.
+	 * \param data    Pointer to the cipher text, which will be overwritten by
+	 *                the plain text.
+	 * \param size    Size of the data, in bytes.
+	 * \param tag     Pointer to the 16-byte tag/MAC.
+	 */
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		const sgx_aes_gcm_128bit_key_t* keyPtr =
+			reinterpret_cast<const sgx_aes_gcm_128bit_key_t*>(m_key.data());
+		const sgx_aes_gcm_128bit_tag_t* tagPtr =
+			reinterpret_cast<const sgx_aes_gcm_128bit_tag_t*>(tag);
+
+		sgx_status_t sgxRet = sgx_rijndael128GCM_decrypt(
+			keyPtr,
+			static_cast<const uint8_t*>(data),
+			static_cast<uint32_t>(size),
+			static_cast<uint8_t*>(data),
+			static_cast<const uint8_t*>(iv),
+			static_cast<uint32_t>(ivSize),
+			static_cast<const uint8_t*>(aad),
+			static_cast<uint32_t>(aadSize),
+			tagPtr
+		);
+		DECENTENCLAVE_CHECK_SGX_RUNTIME_ERROR(
+			sgxRet,
+			sgx_rijndael128GCM_decrypt
+		);
+	}
+
+	/**
+	 * \brief Same as the `EncryptInPlace` above, but the additional
+	 *        authenticated data is given as a list of segments, which are
+	 *        authenticated as if they were concatenated in order.
+	 */
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size
+	)
+	{
+		AadStackBuf aadStackBuf;
+		std::vector<uint8_t> aadHeapBuf;
+		const void* aad = nullptr;
+		size_t aadSize = 0;
+		std::tie(aad, aadSize) =
+			JoinSegments(aadSegs, aadStackBuf, aadHeapBuf);
+
+		return EncryptInPlace(iv, ivSize, aad, aadSize, data, size);
+	}
+
+	/**
+	 * \brief Same as the `DecryptInPlace` above, but the additional
+	 *        authenticated data is given as a list of segments, which are
+	 *        authenticated as if they were concatenated in order.
+	 */
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		AadStackBuf aadStackBuf;
+		std::vector<uint8_t> aadHeapBuf;
+		const void* aad = nullptr;
+		size_t aadSize = 0;
+		std::tie(aad, aadSize) =
+			JoinSegments(aadSegs, aadStackBuf, aadHeapBuf);
+
+		DecryptInPlace(iv, ivSize, aad, aadSize, data, size, tag);
+	}
+
+private: // static members:
+
+	/**
+	 * \brief Joined AAD up to this size is kept on the stack; it covers the
+	 *        packager header (44 bytes) plus the usual caller AAD, e.g., the
+	 *        24 bytes of the secure-channel records.
+	 */
+	static constexpr size_t sk_aadStackSize = 128;
+
+	using AadStackBuf = std::array<uint8_t, sk_aadStackSize>;
+
+	/**
+	 * \brief The SGX SDK only accepts a single AAD buffer, so the segments
+	 *        have to be joined, unless there is at most one non-empty segment;
+	 *        they're joined into `stackBuf`, or into `heapBuf` if they don't
+	 *        fit.
+	 */
+	static AesGcmAadSegment JoinSegments(
+		AesGcmAadSegList aadSegs,
+		AadStackBuf& stackBuf,
+		std::vector<uint8_t>& heapBuf
+	)
+	{
+		size_t totalSize = 0;
+		size_t nonEmptyCount = 0;
+		AesGcmAadSegment lastNonEmpty(nullptr, 0);
+		for (const AesGcmAadSegment& seg : aadSegs)
+		{
+			if (seg.second != 0)
+			{
+				totalSize += seg.second;
+				++nonEmptyCount;
+				lastNonEmpty = seg;
+			}
+		}
+
+		if (nonEmptyCount <= 1)
+		{
+			return lastNonEmpty;
+		}
+
+		uint8_t* dst = stackBuf.data();
+		if (totalSize > stackBuf.size())
+		{
+			heapBuf.resize(totalSize);
+			dst = heapBuf.data();
+		}
+
+		size_t offset = 0;
+		for (const AesGcmAadSegment& seg : aadSegs)
+		{
+			if (seg.second != 0)
+			{
+				std::memcpy(dst + offset, seg.first, seg.second);
+				offset += seg.second;
+			}
+		}
+		return AesGcmAadSegment(dst, totalSize);
+	}
+
 private:
 
 	KeyType m_key;
@@ -150,8 +692,18 @@ private:
 
 #else //#ifdef DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
 
+#ifdef DECENTENCLAVE_AESGCM_HW_X86
+
+/**
+ * \brief AES-GCM implementation using AES-NI and PCLMULQDQ (see
+ *        `AesGcmHwCore`), with the same interface as `AesGcmStateful`.
+ *        It must only be used when `IsAesGcmHwSupported()` is true;
+ *        `AesGcmDispatch` takes care of that.
+ *
+ * \tparam _keyBitSize Size of the key, in bits (128 or 256).
+ */
 template<size_t _keyBitSize>
-class AesGcmOneGoNative
+class AesGcmHw
 {
 public: // static members:
 
@@ -159,25 +711,19 @@ public: // static members:
 	static constexpr size_t sk_keyByteSize = sk_keyBitSize / 8;
 
 	using KeyType = mbedTLScpp::SKey<sk_keyBitSize>;
-
-	using GcmCryptorType =
-		mbedTLScpp::Gcm<mbedTLScpp::CipherType::AES, sk_keyBitSize>;
+	using CoreType = AesGcmHwCore<sk_keyBitSize>;
 
 public:
 
-	AesGcmOneGoNative(KeyType key) :
-		m_cryptor(mbedTLScpp::CtnFullR(key))
+	AesGcmHw(KeyType key) :
+		m_core(key.data())
 	{}
 
-	AesGcmOneGoNative(const AesGcmOneGoNative& other) :
-		m_cryptor(other.m_cryptor)
+	AesGcmHw(const AesGcmHw& other) :
+		m_core(other.m_core)
 	{}
 
-	AesGcmOneGoNative(AesGcmOneGoNative&& other) :
-		m_cryptor(std::move(other.m_cryptor))
-	{}
-
-	~AesGcmOneGoNative() = default;
+	~AesGcmHw() = default;
 
 	template<
 		typename _IvCtnType,   bool _IvCtnSecrecy,
@@ -194,11 +740,17 @@ public:
 		const mbedTLScpp::ContCtnReadOnlyRef<_DataCtnType, _DataCtnSecrecy>& data
 	)
 	{
-		return m_cryptor.Encrypt(
-			data,
-			iv,
-			aad
+		std::vector<uint8_t> res(
+			data.BeginBytePtr(),
+			data.BeginBytePtr() + data.GetRegionSize()
+		);
+		std::array<uint8_t, 16> tag = EncryptInPlace(
+			iv.BeginBytePtr(), iv.GetRegionSize(),
+			aad.BeginBytePtr(), aad.GetRegionSize(),
+			res.data(), res.size()
 		);
+
+		return std::make_pair(std::move(res), tag);
 	}
 
 	template<
@@ -215,23 +767,375 @@ public:
 		const mbedTLScpp::ContCtnReadOnlyRef<_TagCtnType, _TagCtnSecrecy>& tag
 	)
 	{
-		return m_cryptor.Decrypt(
-			data,
-			iv,
-			aad,
-			tag
+		if (tag.GetRegionSize() != 16)
+		{
+			mbedTLScpp::CheckMbedTlsIntRetVal(
+				MBEDTLS_ERR_GCM_AUTH_FAILED,
+				"AesGcmHwCore::CryptAndTag",
+				"DecentEnclave::Common::Platform::AesGcmHw::Decrypt"
+			);
+		}
+
+		mbedTLScpp::SecretVector<uint8_t> res(
+			data.BeginBytePtr(),
+			data.BeginBytePtr() + data.GetRegionSize()
+		);
+		DecryptInPlace(
+			iv.BeginBytePtr(), iv.GetRegionSize(),
+			aad.BeginBytePtr(), aad.GetRegionSize(),
+			res.data(), res.size(),
+			tag.BeginBytePtr()
 		);
+
+		return res;
+	}
+
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size
+	)
+	{
+		return EncryptInPlace(iv, ivSize, { { aad, aadSize } }, data, size);
+	}
+
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		DecryptInPlace(iv, ivSize, { { aad, aadSize } }, data, size, tag);
+	}
+
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size
+	)
+	{
+		std::array<uint8_t, 16> tag;
+
+		StartWithSegments(iv, ivSize, aadSegs);
+		m_core.CryptAndTag(true, data, size, tag.data());
+
+		return tag;
+	}
+
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		std::array<uint8_t, 16> calcTag;
+
+		StartWithSegments(iv, ivSize, aadSegs);
+		m_core.CryptAndTag(false, data, size, calcTag.data());
+
+		// constant time comparison
+		const uint8_t* tagPtr = static_cast<const uint8_t*>(tag);
+		uint8_t diff = 0;
+		for (size_t i = 0; i < calcTag.size(); ++i)
+		{
+			diff |= (calcTag[i] ^ tagPtr[i]);
+		}
+		if (diff != 0)
+		{
+			// don't leave unauthenticated plain text in the buffer
+			mbedtls_platform_zeroize(data, size);
+			mbedTLScpp::CheckMbedTlsIntRetVal(
+				MBEDTLS_ERR_GCM_AUTH_FAILED,
+				"AesGcmHwCore::CryptAndTag",
+				"DecentEnclave::Common::Platform::AesGcmHw::DecryptInPlace"
+			);
+		}
 	}
 
 private:
 
-	GcmCryptorType m_cryptor;
+	void StartWithSegments(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs
+	)
+	{
+		m_core.Starts(iv, ivSize);
+		for (const AesGcmAadSegment& seg : aadSegs)
+		{
+			if (seg.second == 0)
+			{
+				continue;
+			}
+			m_core.UpdateAad(seg.first, seg.second);
+		}
+	}
 
-}; // class AesGcmOneGoNative
+	CoreType m_core;
+
+}; // class AesGcmHw
+
+
+/**
+ * \brief AES-GCM implementation selecting its backend at runtime:
+ *        `AesGcmHw` if the CPU supports it and it passes the known-answer
+ *        tests (checked once per key size), otherwise `AesGcmStateful`
+ *        (mbedTLS).
+ *
+ * \tparam _keyBitSize Size of the key, in bits.
+ */
+template<size_t _keyBitSize>
+class AesGcmDispatch
+{
+public: // static members:
+
+	static constexpr size_t sk_keyBitSize = _keyBitSize;
+	static constexpr size_t sk_keyByteSize = sk_keyBitSize / 8;
+
+	using KeyType = mbedTLScpp::SKey<sk_keyBitSize>;
+	using HwType = AesGcmHw<sk_keyBitSize>;
+	using FallbackType = AesGcmStateful<sk_keyBitSize>;
+
+	/**
+	 * \brief Whether the hardware-accelerated backend is used for this key
+	 *        size.
+	 */
+	static bool IsHwBackendUsed()
+	{
+		static const bool s_isHwUsed = IsHwBackendUsable(
+			std::integral_constant<
+				bool,
+				AesGcmHwCore<sk_keyBitSize>::sk_isKeySizeSupported
+			>()
+		);
+		return s_isHwUsed;
+	}
+
+private: // static members:
+
+	static bool IsHwBackendUsable(std::true_type)
+	{
+		return IsAesGcmHwSupported() && AesGcmKnownAnswerTest<HwType>();
+	}
+
+	static bool IsHwBackendUsable(std::false_type)
+	{
+		return false;
+	}
+
+	static std::unique_ptr<HwType> MakeHw(const KeyType& key, std::true_type)
+	{
+		return std::unique_ptr<HwType>(new HwType(key));
+	}
+
+	static std::unique_ptr<HwType> MakeHw(const KeyType&, std::false_type)
+	{
+		return nullptr;
+	}
+
+public:
+
+	AesGcmDispatch(KeyType key) :
+		m_hw(),
+		m_fallback()
+	{
+		if (IsHwBackendUsed())
+		{
+			m_hw = MakeHw(
+				key,
+				std::integral_constant<
+					bool,
+					AesGcmHwCore<sk_keyBitSize>::sk_isKeySizeSupported
+				>()
+			);
+		}
+		else
+		{
+			m_fallback =
+				std::unique_ptr<FallbackType>(new FallbackType(std::move(key)));
+		}
+	}
+
+	AesGcmDispatch(const AesGcmDispatch& other) :
+		m_hw(
+			other.m_hw ? std::unique_ptr<HwType>(new HwType(*other.m_hw)) :
+			nullptr
+		),
+		m_fallback(
+			other.m_fallback ?
+				std::unique_ptr<FallbackType>(
+					new FallbackType(*other.m_fallback)
+				) :
+				nullptr
+		)
+	{}
+
+	AesGcmDispatch(AesGcmDispatch&& other) :
+		m_hw(std::move(other.m_hw)),
+		m_fallback(std::move(other.m_fallback))
+	{}
+
+	~AesGcmDispatch() = default;
+
+	template<
+		typename _IvCtnType,   bool _IvCtnSecrecy,
+		typename _AadCtnType,  bool _AadCtnSecrecy,
+		typename _DataCtnType, bool _DataCtnSecrecy
+	>
+	std::pair<
+		std::vector<uint8_t>,
+		std::array<uint8_t, 16>
+	>
+	Encrypt(
+		const mbedTLScpp::ContCtnReadOnlyRef<_IvCtnType,   _IvCtnSecrecy>& iv,
+		const mbedTLScpp::ContCtnReadOnlyRef<_AadCtnType,  _AadCtnSecrecy>& aad,
+		const mbedTLScpp::ContCtnReadOnlyRef<_DataCtnType, _DataCtnSecrecy>& data
+	)
+	{
+		return m_hw ?
+			m_hw->Encrypt(iv, aad, data) :
+			m_fallback->Encrypt(iv, aad, data);
+	}
+
+	template<
+		typename _IvCtnType,   bool _IvCtnSecrecy,
+		typename _AadCtnType,  bool _AadCtnSecrecy,
+		typename _DataCtnType, bool _DataCtnSecrecy,
+		typename _TagCtnType,  bool _TagCtnSecrecy
+	>
+	mbedTLScpp::SecretVector<uint8_t>
+	Decrypt(
+		const mbedTLScpp::ContCtnReadOnlyRef<_IvCtnType,   _IvCtnSecrecy>& iv,
+		const mbedTLScpp::ContCtnReadOnlyRef<_AadCtnType,  _AadCtnSecrecy>& aad,
+		const mbedTLScpp::ContCtnReadOnlyRef<_DataCtnType, _DataCtnSecrecy>& data,
+		const mbedTLScpp::ContCtnReadOnlyRef<_TagCtnType, _TagCtnSecrecy>& tag
+	)
+	{
+		return m_hw ?
+			m_hw->Decrypt(iv, aad, data, tag) :
+			m_fallback->Decrypt(iv, aad, data, tag);
+	}
+
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size
+	)
+	{
+		return m_hw ?
+			m_hw->EncryptInPlace(iv, ivSize, aad, aadSize, data, size) :
+			m_fallback->EncryptInPlace(iv, ivSize, aad, aadSize, data, size);
+	}
+
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		const void* aad,
+		size_t aadSize,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		m_hw ?
+			m_hw->DecryptInPlace(iv, ivSize, aad, aadSize, data, size, tag) :
+			m_fallback->DecryptInPlace(iv, ivSize, aad, aadSize, data, size, tag);
+	}
+
+	std::array<uint8_t, 16> EncryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size
+	)
+	{
+		return m_hw ?
+			m_hw->EncryptInPlace(iv, ivSize, aadSegs, data, size) :
+			m_fallback->EncryptInPlace(iv, ivSize, aadSegs, data, size);
+	}
+
+	void DecryptInPlace(
+		const void* iv,
+		size_t ivSize,
+		AesGcmAadSegList aadSegs,
+		void* data,
+		size_t size,
+		const void* tag
+	)
+	{
+		m_hw ?
+			m_hw->DecryptInPlace(iv, ivSize, aadSegs, data, size, tag) :
+			m_fallback->DecryptInPlace(iv, ivSize, aadSegs, data, size, tag);
+	}
+
+private:
+
+	std::unique_ptr<HwType> m_hw;
+	std::unique_ptr<FallbackType> m_fallback;
+
+}; // class AesGcmDispatch
+
+
+/**
+ * \brief On untrusted x86-64 platforms, the backend is selected at runtime,
+ *        between AES-NI/PCLMULQDQ and mbedTLS; both keep their context
+ *        for the whole lifetime.
+ */
+template<size_t _keyBitSize>
+using AesGcmOneGoNative = AesGcmDispatch<_keyBitSize>;
+
+#else // DECENTENCLAVE_AESGCM_HW_X86
+
+/**
+ * \brief On other untrusted platforms, the mbedTLS-based implementation is
+ *        used, which already keeps its context for the whole lifetime.
+ */
+template<size_t _keyBitSize>
+using AesGcmOneGoNative = AesGcmStateful<_keyBitSize>;
+
+#endif // DECENTENCLAVE_AESGCM_HW_X86
 
 #endif // DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
 
 
+/**
+ * \brief The AES-GCM implementation used by long-lived packagers, such as
+ *        the ones used by secure channels, where the same key is used to seal
+ *        many (usually small) messages.
+ *        It's `AesGcmOneGoNative`; so, inside SGX enclaves, it's the SGX SDK
+ *        (AES-NI) backend, which still expands the key for every message.
+ *        Defining `DECENTENCLAVE_AESGCM_STATEFUL` switches enclaves to the
+ *        mbedTLS backend, which keeps the key setup across messages, at the
+ *        cost of a context per packager, but whose software AES has not
+ *        been measured against the SDK's; it's an experimental option, not
+ *        a persistent context for the SDK backend.
+ */
+#if defined(DECENTENCLAVE_AESGCM_STATEFUL) && \
+	defined(DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED)
+template<size_t _keyBitSize>
+using AesGcmSessionNative = AesGcmStateful<_keyBitSize>;
+#else // DECENTENCLAVE_AESGCM_STATEFUL && DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
+template<size_t _keyBitSize>
+using AesGcmSessionNative = AesGcmOneGoNative<_keyBitSize>;
+#endif // DECENTENCLAVE_AESGCM_STATEFUL && DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
+
+
 } // namespace Platform
 } // namespace Common
 } // namespace DecentEnclave
@@ -0,0 +1,643 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+/**
+ * @brief The hardware-accelerated AES-GCM core (AES-NI + PCLMULQDQ) is only
+ *        compiled for untrusted x86-64 builds with GCC or Clang, since it
+ *        relies on per-function target attributes so the rest of the
+ *        program doesn't need to be built with these instruction sets.
+ *        Define DECENTENCLAVE_AESGCM_NO_HW to disable it entirely.
+ */
+#if !defined(DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED) && \
+	!defined(DECENTENCLAVE_AESGCM_NO_HW) && \
+	defined(__GNUC__) && \
+	defined(__x86_64__)
+#define DECENTENCLAVE_AESGCM_HW_X86
+#endif
+
+
+#ifdef DECENTENCLAVE_AESGCM_HW_X86
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <type_traits>
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#include <mbedtls/platform_util.h>
+
+
+#define DECENTENCLAVE_AESGCM_HW_TARGET \
+	__attribute__((target("aes,pclmul,ssse3,sse4.1")))
+
+
+namespace DecentEnclave
+{
+namespace Common
+{
+namespace Platform
+{
+
+
+/**
+ * \brief Checks if the CPU running this program supports the instructions
+ *        needed by `AesGcmHwCore` (AES-NI, PCLMULQDQ, SSSE3 and SSE4.1).
+ *        The result is detected once, and then cached.
+ */
+inline bool IsAesGcmHwSupported()
+{
+	static const bool s_isSupported = []()
+	{
+		unsigned int eax = 0;
+		unsigned int ebx = 0;
+		unsigned int ecx = 0;
+		unsigned int edx = 0;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+		{
+			return false;
+		}
+
+		return
+			((ecx & bit_AES)    != 0) &&
+			((ecx & bit_PCLMUL) != 0) &&
+			((ecx & bit_SSSE3)  != 0) &&
+			((ecx & bit_SSE4_1) != 0);
+	}();
+
+	return s_isSupported;
+}
+
+
+namespace AesGcmHwImpl
+{
+
+
+/** \brief Number of AES rounds for each supported key size; 0 if unsupported */
+template<size_t _keyBitSize>
+struct AesRounds : std::integral_constant<size_t, 0>
+{};
+
+template<>
+struct AesRounds<128> : std::integral_constant<size_t, 10>
+{};
+
+template<>
+struct AesRounds<256> : std::integral_constant<size_t, 14>
+{};
+
+
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline __m128i ByteSwap(__m128i x)
+{
+	const __m128i mask = _mm_set_epi8(
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+	);
+	return _mm_shuffle_epi8(x, mask);
+}
+
+
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline __m128i KeyExpStep(__m128i key, __m128i keyGened)
+{
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, keyGened);
+}
+
+
+#define DECENTENCLAVE_AESGCM_HW_EXP128(RK, I, RCON) \
+	RK[I] = KeyExpStep( \
+		RK[I - 1], \
+		_mm_shuffle_epi32(_mm_aeskeygenassist_si128(RK[I - 1], RCON), 0xFF) \
+	)
+
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline void ExpandKey(
+	std::integral_constant<size_t, 128>,
+	const uint8_t* key,
+	__m128i* rk
+)
+{
+	rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  1, 0x01);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  2, 0x02);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  3, 0x04);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  4, 0x08);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  5, 0x10);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  6, 0x20);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  7, 0x40);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  8, 0x80);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk,  9, 0x1B);
+	DECENTENCLAVE_AESGCM_HW_EXP128(rk, 10, 0x36);
+}
+
+#undef DECENTENCLAVE_AESGCM_HW_EXP128
+
+
+#define DECENTENCLAVE_AESGCM_HW_EXP256(RK, I, RCON) \
+	RK[I] = KeyExpStep( \
+		RK[I - 2], \
+		_mm_shuffle_epi32(_mm_aeskeygenassist_si128(RK[I - 1], RCON), 0xFF) \
+	); \
+	RK[I + 1] = KeyExpStep( \
+		RK[I - 1], \
+		_mm_shuffle_epi32(_mm_aeskeygenassist_si128(RK[I], 0x00), 0xAA) \
+	)
+
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline void ExpandKey(
+	std::integral_constant<size_t, 256>,
+	const uint8_t* key,
+	__m128i* rk
+)
+{
+	rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+	rk[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+	DECENTENCLAVE_AESGCM_HW_EXP256(rk,  2, 0x01);
+	DECENTENCLAVE_AESGCM_HW_EXP256(rk,  4, 0x02);
+	DECENTENCLAVE_AESGCM_HW_EXP256(rk,  6, 0x04);
+	DECENTENCLAVE_AESGCM_HW_EXP256(rk,  8, 0x08);
+	DECENTENCLAVE_AESGCM_HW_EXP256(rk, 10, 0x10);
+	DECENTENCLAVE_AESGCM_HW_EXP256(rk, 12, 0x20);
+	rk[14] = KeyExpStep(
+		rk[12],
+		_mm_shuffle_epi32(_mm_aeskeygenassist_si128(rk[13], 0x40), 0xFF)
+	);
+}
+
+#undef DECENTENCLAVE_AESGCM_HW_EXP256
+
+
+template<size_t _rounds>
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline __m128i AesEnc1(const __m128i* rk, __m128i b)
+{
+	b = _mm_xor_si128(b, rk[0]);
+	for (size_t i = 1; i < _rounds; ++i)
+	{
+		b = _mm_aesenc_si128(b, rk[i]);
+	}
+	return _mm_aesenclast_si128(b, rk[_rounds]);
+}
+
+
+/** \brief Encrypts 4 blocks at once, to keep the AES pipeline busy */
+template<size_t _rounds>
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline void AesEnc4(const __m128i* rk, __m128i* b)
+{
+	b[0] = _mm_xor_si128(b[0], rk[0]);
+	b[1] = _mm_xor_si128(b[1], rk[0]);
+	b[2] = _mm_xor_si128(b[2], rk[0]);
+	b[3] = _mm_xor_si128(b[3], rk[0]);
+	for (size_t i = 1; i < _rounds; ++i)
+	{
+		b[0] = _mm_aesenc_si128(b[0], rk[i]);
+		b[1] = _mm_aesenc_si128(b[1], rk[i]);
+		b[2] = _mm_aesenc_si128(b[2], rk[i]);
+		b[3] = _mm_aesenc_si128(b[3], rk[i]);
+	}
+	b[0] = _mm_aesenclast_si128(b[0], rk[_rounds]);
+	b[1] = _mm_aesenclast_si128(b[1], rk[_rounds]);
+	b[2] = _mm_aesenclast_si128(b[2], rk[_rounds]);
+	b[3] = _mm_aesenclast_si128(b[3], rk[_rounds]);
+}
+
+
+/**
+ * \brief Carry-less multiplication of two (byte-swapped) GHASH elements,
+ *        without reduction; the 256-bit result is accumulated into
+ *        (lo, hi), so several products can share one reduction.
+ */
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline void ClMulAcc(__m128i a, __m128i b, __m128i& lo, __m128i& hi)
+{
+	const __m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+	const __m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+	const __m128i t1 = _mm_xor_si128(
+		_mm_clmulepi64_si128(a, b, 0x10),
+		_mm_clmulepi64_si128(a, b, 0x01)
+	);
+
+	lo = _mm_xor_si128(lo, _mm_xor_si128(t0, _mm_slli_si128(t1, 8)));
+	hi = _mm_xor_si128(hi, _mm_xor_si128(t3, _mm_srli_si128(t1, 8)));
+}
+
+
+/**
+ * \brief Reduces a 256-bit product modulo the GCM polynomial
+ *        (shift left by one, for the bit-reflected representation, and
+ *        reduction; see Intel's white paper on CLMUL and GCM).
+ */
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline __m128i Reduce(__m128i lo, __m128i hi)
+{
+	__m128i t7 = _mm_srli_epi32(lo, 31);
+	__m128i t8 = _mm_srli_epi32(hi, 31);
+	lo = _mm_slli_epi32(lo, 1);
+	hi = _mm_slli_epi32(hi, 1);
+
+	const __m128i t9 = _mm_srli_si128(t7, 12);
+	t8 = _mm_slli_si128(t8, 4);
+	t7 = _mm_slli_si128(t7, 4);
+	lo = _mm_or_si128(lo, t7);
+	hi = _mm_or_si128(hi, t8);
+	hi = _mm_or_si128(hi, t9);
+
+	t7 = _mm_slli_epi32(lo, 31);
+	t8 = _mm_slli_epi32(lo, 30);
+	__m128i t9b = _mm_slli_epi32(lo, 25);
+	t7 = _mm_xor_si128(t7, t8);
+	t7 = _mm_xor_si128(t7, t9b);
+	t8 = _mm_srli_si128(t7, 4);
+	t7 = _mm_slli_si128(t7, 12);
+	lo = _mm_xor_si128(lo, t7);
+
+	__m128i t2 = _mm_srli_epi32(lo, 1);
+	const __m128i t4 = _mm_srli_epi32(lo, 2);
+	const __m128i t5 = _mm_srli_epi32(lo, 7);
+	t2 = _mm_xor_si128(t2, t4);
+	t2 = _mm_xor_si128(t2, t5);
+	t2 = _mm_xor_si128(t2, t8);
+	lo = _mm_xor_si128(lo, t2);
+
+	return _mm_xor_si128(hi, lo);
+}
+
+
+DECENTENCLAVE_AESGCM_HW_TARGET
+inline __m128i GfMul(__m128i a, __m128i b)
+{
+	__m128i lo = _mm_setzero_si128();
+	__m128i hi = _mm_setzero_si128();
+	ClMulAcc(a, b, lo, hi);
+	return Reduce(lo, hi);
+}
+
+
+} // namespace AesGcmHwImpl
+
+
+/**
+ * \brief AES-GCM core using AES-NI and PCLMULQDQ.
+ *        The key schedule and the powers of the hash key are computed once
+ *        at construction. A message is processed by `Starts`, any number
+ *        of `UpdateAad`, and then one `CryptAndTag` for the whole data.
+ *        Only construct it when `IsAesGcmHwSupported()` returns true, and
+ *        with a key size for which `sk_isKeySizeSupported` is true.
+ *
+ * \tparam _keyBitSize Size of the key, in bits.
+ */
+template<size_t _keyBitSize>
+class AesGcmHwCore
+{
+public: // static members:
+
+	static constexpr size_t sk_keyBitSize = _keyBitSize;
+	static constexpr size_t sk_keyByteSize = sk_keyBitSize / 8;
+	static constexpr size_t sk_rounds = AesGcmHwImpl::AesRounds<_keyBitSize>::value;
+	static constexpr bool sk_isKeySizeSupported = (sk_rounds != 0);
+
+public:
+
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	AesGcmHwCore(const uint8_t* key) :
+		m_roundKeys(),
+		m_hPow(),
+		m_j0(),
+		m_ctr(0),
+		m_x(),
+		m_aadSize(0),
+		m_partial(),
+		m_partialSize(0)
+	{
+		AesGcmHwImpl::ExpandKey(
+			std::integral_constant<size_t, sk_keyBitSize>(),
+			key,
+			m_roundKeys
+		);
+
+		// H = E(K, 0^128), kept byte-swapped, with H^2 ~ H^4 for the
+		// aggregated GHASH of 4 blocks
+		const __m128i h = AesGcmHwImpl::ByteSwap(
+			AesGcmHwImpl::AesEnc1<sk_rounds>(m_roundKeys, _mm_setzero_si128())
+		);
+		m_hPow[0] = h;
+		m_hPow[1] = AesGcmHwImpl::GfMul(m_hPow[0], h);
+		m_hPow[2] = AesGcmHwImpl::GfMul(m_hPow[1], h);
+		m_hPow[3] = AesGcmHwImpl::GfMul(m_hPow[2], h);
+	}
+
+	AesGcmHwCore(const AesGcmHwCore& other) = default;
+
+	// LCOV_EXCL_START
+	~AesGcmHwCore()
+	{
+		mbedtls_platform_zeroize(m_roundKeys, sizeof(m_roundKeys));
+		mbedtls_platform_zeroize(m_hPow, sizeof(m_hPow));
+		mbedtls_platform_zeroize(&m_j0, sizeof(m_j0));
+		mbedtls_platform_zeroize(&m_x, sizeof(m_x));
+		mbedtls_platform_zeroize(m_partial, sizeof(m_partial));
+	}
+	// LCOV_EXCL_STOP
+
+	AesGcmHwCore& operator=(const AesGcmHwCore& other) = default;
+
+	/**
+	 * \brief Starts a new message with the given IV.
+	 */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void Starts(const void* iv, size_t ivSize)
+	{
+		const uint8_t* ivPtr = static_cast<const uint8_t*>(iv);
+
+		if (ivSize == 12)
+		{
+			// J0 = IV || 0^31 || 1
+			uint8_t j0[16] = { 0 };
+			std::memcpy(j0, ivPtr, ivSize);
+			j0[15] = 1;
+			m_j0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(j0));
+		}
+		else
+		{
+			// J0 = GHASH(IV || 0^s || 0^64 || [len(IV)]_64)
+			m_x = _mm_setzero_si128();
+			m_partialSize = 0;
+			AbsorbStream(ivPtr, ivSize);
+			AbsorbPartial();
+			AbsorbLengths(0, static_cast<uint64_t>(ivSize) * 8);
+			m_j0 = AesGcmHwImpl::ByteSwap(m_x);
+		}
+
+		uint32_t ctrBe = 0;
+		std::memcpy(&ctrBe, reinterpret_cast<const uint8_t*>(&m_j0) + 12, 4);
+		m_ctr = __builtin_bswap32(ctrBe);
+
+		m_x = _mm_setzero_si128();
+		m_aadSize = 0;
+		m_partialSize = 0;
+	}
+
+	/**
+	 * \brief Feeds more additional authenticated data; segments given by
+	 *        successive calls are authenticated as if they were concatenated.
+	 */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void UpdateAad(const void* aad, size_t aadSize)
+	{
+		m_aadSize += aadSize;
+		AbsorbStream(static_cast<const uint8_t*>(aad), aadSize);
+	}
+
+	/**
+	 * \brief Encrypts or decrypts the whole data in place, and outputs the
+	 *        16-byte tag computed (over the cipher text).
+	 */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void CryptAndTag(bool isEncrypt, void* data, size_t size, uint8_t* tag)
+	{
+		using namespace AesGcmHwImpl;
+
+		AbsorbPartial();
+
+		uint8_t* ptr = static_cast<uint8_t*>(data);
+		size_t left = size;
+		uint32_t ctr = m_ctr;
+
+		while (left >= 64)
+		{
+			__m128i ks[4] = {
+				CtrBlock(++ctr),
+				CtrBlock(++ctr),
+				CtrBlock(++ctr),
+				CtrBlock(++ctr),
+			};
+			AesEnc4<sk_rounds>(m_roundKeys, ks);
+
+			if (!isEncrypt)
+			{
+				AbsorbBlocks4(ptr);
+			}
+			for (size_t i = 0; i < 4; ++i)
+			{
+				__m128i* blk = reinterpret_cast<__m128i*>(ptr + (i * 16));
+				_mm_storeu_si128(
+					blk,
+					_mm_xor_si128(_mm_loadu_si128(blk), ks[i])
+				);
+			}
+			if (isEncrypt)
+			{
+				AbsorbBlocks4(ptr);
+			}
+
+			ptr += 64;
+			left -= 64;
+		}
+
+		while (left >= 16)
+		{
+			const __m128i ks = AesEnc1<sk_rounds>(m_roundKeys, CtrBlock(++ctr));
+			__m128i* blk = reinterpret_cast<__m128i*>(ptr);
+
+			if (!isEncrypt)
+			{
+				AbsorbBlock(_mm_loadu_si128(blk));
+			}
+			const __m128i res = _mm_xor_si128(_mm_loadu_si128(blk), ks);
+			_mm_storeu_si128(blk, res);
+			if (isEncrypt)
+			{
+				AbsorbBlock(res);
+			}
+
+			ptr += 16;
+			left -= 16;
+		}
+
+		if (left > 0)
+		{
+			uint8_t ks[16];
+			_mm_storeu_si128(
+				reinterpret_cast<__m128i*>(ks),
+				AesEnc1<sk_rounds>(m_roundKeys, CtrBlock(++ctr))
+			);
+
+			uint8_t last[16] = { 0 };
+			std::memcpy(last, ptr, left);
+			if (!isEncrypt)
+			{
+				AbsorbBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(last)));
+			}
+			for (size_t i = 0; i < left; ++i)
+			{
+				last[i] ^= ks[i];
+			}
+			std::memcpy(ptr, last, left);
+			if (isEncrypt)
+			{
+				std::memset(last + left, 0, sizeof(last) - left);
+				AbsorbBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(last)));
+			}
+
+			mbedtls_platform_zeroize(ks, sizeof(ks));
+			mbedtls_platform_zeroize(last, sizeof(last));
+		}
+
+		AbsorbLengths(
+			static_cast<uint64_t>(m_aadSize) * 8,
+			static_cast<uint64_t>(size) * 8
+		);
+
+		const __m128i tagBlk = _mm_xor_si128(
+			AesEnc1<sk_rounds>(m_roundKeys, m_j0),
+			ByteSwap(m_x)
+		);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tag), tagBlk);
+	}
+
+private:
+
+	/** \brief Counter block: J0 with its last 32 bits replaced by ctr */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	__m128i CtrBlock(uint32_t ctr) const
+	{
+		return _mm_insert_epi32(
+			m_j0,
+			static_cast<int>(__builtin_bswap32(ctr)),
+			3
+		);
+	}
+
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void AbsorbBlock(__m128i blk)
+	{
+		m_x = AesGcmHwImpl::GfMul(
+			_mm_xor_si128(m_x, AesGcmHwImpl::ByteSwap(blk)),
+			m_hPow[0]
+		);
+	}
+
+	/**
+	 * \brief X = (X + B0)H^4 + B1*H^3 + B2*H^2 + B3*H, with one reduction.
+	 */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void AbsorbBlocks4(const uint8_t* ptr)
+	{
+		using namespace AesGcmHwImpl;
+
+		const __m128i* blk = reinterpret_cast<const __m128i*>(ptr);
+		__m128i lo = _mm_setzero_si128();
+		__m128i hi = _mm_setzero_si128();
+
+		ClMulAcc(
+			_mm_xor_si128(m_x, ByteSwap(_mm_loadu_si128(blk))),
+			m_hPow[3],
+			lo, hi
+		);
+		ClMulAcc(ByteSwap(_mm_loadu_si128(blk + 1)), m_hPow[2], lo, hi);
+		ClMulAcc(ByteSwap(_mm_loadu_si128(blk + 2)), m_hPow[1], lo, hi);
+		ClMulAcc(ByteSwap(_mm_loadu_si128(blk + 3)), m_hPow[0], lo, hi);
+
+		m_x = Reduce(lo, hi);
+	}
+
+	/** \brief Absorbs a byte stream, keeping any incomplete block pending */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void AbsorbStream(const uint8_t* ptr, size_t size)
+	{
+		if (m_partialSize > 0)
+		{
+			const size_t take = (16 - m_partialSize) < size ?
+				(16 - m_partialSize) : size;
+			std::memcpy(m_partial + m_partialSize, ptr, take);
+			m_partialSize += take;
+			ptr += take;
+			size -= take;
+
+			if (m_partialSize < 16)
+			{
+				return;
+			}
+			AbsorbBlock(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_partial))
+			);
+			m_partialSize = 0;
+		}
+
+		while (size >= 64)
+		{
+			AbsorbBlocks4(ptr);
+			ptr += 64;
+			size -= 64;
+		}
+		while (size >= 16)
+		{
+			AbsorbBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+			ptr += 16;
+			size -= 16;
+		}
+
+		if (size > 0)
+		{
+			std::memcpy(m_partial, ptr, size);
+			m_partialSize = size;
+		}
+	}
+
+	/** \brief Absorbs the pending incomplete block, padded with zeros */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void AbsorbPartial()
+	{
+		if (m_partialSize > 0)
+		{
+			std::memset(m_partial + m_partialSize, 0, 16 - m_partialSize);
+			AbsorbBlock(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_partial))
+			);
+			m_partialSize = 0;
+		}
+	}
+
+	/** \brief Absorbs the block of [len(A)]_64 || [len(C)]_64, in bits */
+	DECENTENCLAVE_AESGCM_HW_TARGET
+	void AbsorbLengths(uint64_t aadBits, uint64_t dataBits)
+	{
+		// already in the byte-swapped representation
+		const __m128i lens = _mm_set_epi64x(
+			static_cast<long long>(aadBits),
+			static_cast<long long>(dataBits)
+		);
+		m_x = AesGcmHwImpl::GfMul(_mm_xor_si128(m_x, lens), m_hPow[0]);
+	}
+
+	__m128i m_roundKeys[sk_rounds + 1];
+	__m128i m_hPow[4]; // H, H^2, H^3, H^4 (byte-swapped)
+
+	__m128i m_j0;
+	uint32_t m_ctr;
+	__m128i m_x;
+	size_t m_aadSize;
+	uint8_t m_partial[16];
+	size_t m_partialSize;
+
+}; // class AesGcmHwCore
+
+
+} // namespace Platform
+} // namespace Common
+} // namespace DecentEnclave
+
+
+#endif // DECENTENCLAVE_AESGCM_HW_X86
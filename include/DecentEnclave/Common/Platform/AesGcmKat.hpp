@@ -0,0 +1,353 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <vector>
+
+
+namespace DecentEnclave
+{
+namespace Common
+{
+namespace Platform
+{
+
+
+namespace AesGcmKatImpl
+{
+
+
+struct AesGcmKatVector
+{
+	size_t m_keyBitSize;
+	const char* m_key;
+	const char* m_iv;
+	const char* m_aad;
+	const char* m_plain;
+	const char* m_cipher;
+	const char* m_tag;
+}; // struct AesGcmKatVector
+
+
+/**
+ * \brief Test cases 2, 3, 4, 6, 14, 15 and 16 from the GCM specification
+ *        (McGrew and Viega, "The Galois/Counter Mode of Operation"),
+ *        followed by test cases 3 and 15 with a 160-byte AAD (the AAD of
+ *        test case 4 repeated 8 times), whose tags were cross-checked
+ *        against OpenSSL.
+ *        Test cases 3 and 15 have a 64-byte plain text, and the last two
+ *        have a multi-block AAD, so that the 4-block paths of the
+ *        hardware backend are covered.
+ */
+inline const std::array<AesGcmKatVector, 9>& GetAesGcmKatVectors()
+{
+	static const char* s_plain3 =
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b391aafd255";
+	static const char* s_plain4 =
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b39";
+	static const char* s_aad4 =
+		"feedfacedeadbeeffeedfacedeadbeef"
+		"abaddad2";
+	static const char* s_aadLong =
+		"feedfacedeadbeeffeedfacedeadbeef"
+		"abaddad2feedfacedeadbeeffeedface"
+		"deadbeefabaddad2feedfacedeadbeef"
+		"feedfacedeadbeefabaddad2feedface"
+		"deadbeeffeedfacedeadbeefabaddad2"
+		"feedfacedeadbeeffeedfacedeadbeef"
+		"abaddad2feedfacedeadbeeffeedface"
+		"deadbeefabaddad2feedfacedeadbeef"
+		"feedfacedeadbeefabaddad2feedface"
+		"deadbeeffeedfacedeadbeefabaddad2";
+	static const char* s_cipher3 =
+		"42831ec2217774244b7221b784d0d49c"
+		"e3aa212f2c02a4e035c17e2329aca12e"
+		"21d514b25466931c7d8f6a5aac84aa05"
+		"1ba30b396a0aac973d58e091473f5985";
+	static const char* s_cipher15 =
+		"522dc1f099567d07f47f37a32a84427d"
+		"643a8cdcbfe5c0c97598a2bd2555d1aa"
+		"8cb08e48590dbb3da7b08b1056828838"
+		"c5f61e6393ba7a0abcc9f662898015ad";
+
+	static const std::array<AesGcmKatVector, 9> s_vectors = {{
+		{
+			128,
+			"00000000000000000000000000000000",
+			"000000000000000000000000",
+			"",
+			"00000000000000000000000000000000",
+			"0388dace60b6a392f328c2b971b2fe78",
+			"ab6e47d42cec13bdf53a67b21257bddf",
+		},
+		{
+			128,
+			"feffe9928665731c6d6a8f9467308308",
+			"cafebabefacedbaddecaf888",
+			"",
+			s_plain3,
+			s_cipher3,
+			"4d5c2af327cd64a62cf35abd2ba6fab4",
+		},
+		{
+			128,
+			"feffe9928665731c6d6a8f9467308308",
+			"cafebabefacedbaddecaf888",
+			s_aad4,
+			s_plain4,
+			"42831ec2217774244b7221b784d0d49c"
+			"e3aa212f2c02a4e035c17e2329aca12e"
+			"21d514b25466931c7d8f6a5aac84aa05"
+			"1ba30b396a0aac973d58e091",
+			"5bc94fbc3221a5db94fae95ae7121a47",
+		},
+		{
+			128,
+			"feffe9928665731c6d6a8f9467308308",
+			"9313225df88406e555909c5aff5269aa"
+			"6a7a9538534f7da1e4c303d2a318a728"
+			"c3c0c95156809539fcf0e2429a6b5254"
+			"16aedbf5a0de6a57a637b39b",
+			s_aad4,
+			s_plain4,
+			"8ce24998625615b603a033aca13fb894"
+			"be9112a5c3a211a8ba262a3cca7e2ca7"
+			"01e4a9a4fba43c90ccdcb281d48c7c6f"
+			"d62875d2aca417034c34aee5",
+			"619cc5aefffe0bfa462af43c1699d050",
+		},
+		{
+			256,
+			"00000000000000000000000000000000"
+			"00000000000000000000000000000000",
+			"000000000000000000000000",
+			"",
+			"00000000000000000000000000000000",
+			"cea7403d4d606b6e074ec5d3baf39d18",
+			"d0d1c8a799996bf0265b98b5d48ab919",
+		},
+		{
+			256,
+			"feffe9928665731c6d6a8f9467308308"
+			"feffe9928665731c6d6a8f9467308308",
+			"cafebabefacedbaddecaf888",
+			"",
+			s_plain3,
+			s_cipher15,
+			"b094dac5d93471bdec1a502270e3cc6c",
+		},
+		{
+			256,
+			"feffe9928665731c6d6a8f9467308308"
+			"feffe9928665731c6d6a8f9467308308",
+			"cafebabefacedbaddecaf888",
+			s_aad4,
+			s_plain4,
+			"522dc1f099567d07f47f37a32a84427d"
+			"643a8cdcbfe5c0c97598a2bd2555d1aa"
+			"8cb08e48590dbb3da7b08b1056828838"
+			"c5f61e6393ba7a0abcc9f662",
+			"76fc6ece0f4e1768cddf8853bb2d551b",
+		},
+		{
+			128,
+			"feffe9928665731c6d6a8f9467308308",
+			"cafebabefacedbaddecaf888",
+			s_aadLong,
+			s_plain3,
+			s_cipher3,
+			"10aa613dab769bbbf32bfea22998ecf8",
+		},
+		{
+			256,
+			"feffe9928665731c6d6a8f9467308308"
+			"feffe9928665731c6d6a8f9467308308",
+			"cafebabefacedbaddecaf888",
+			s_aadLong,
+			s_plain3,
+			s_cipher15,
+			"d214865ba9a998859211c39758f0805f",
+		},
+	}};
+
+	return s_vectors;
+}
+
+
+inline std::vector<uint8_t> HexToBytes(const char* hex)
+{
+	auto nibble = [](char c) -> uint8_t
+	{
+		return static_cast<uint8_t>(
+			(c >= '0' && c <= '9') ? (c - '0') : (c - 'a' + 10)
+		);
+	};
+
+	std::vector<uint8_t> res(std::strlen(hex) / 2);
+	for (size_t i = 0; i < res.size(); ++i)
+	{
+		res[i] = static_cast<uint8_t>(
+			(nibble(hex[2 * i]) << 4) | nibble(hex[(2 * i) + 1])
+		);
+	}
+	return res;
+}
+
+
+} // namespace AesGcmKatImpl
+
+
+/**
+ * \brief Runs the known-answer tests against an AES-GCM implementation
+ *        (any of the ones in AesGcm.hpp), covering the single-AAD and the
+ *        segmented-AAD in-place APIs, and the rejection of a modified tag.
+ *        Only the test vectors matching the implementation's key size are
+ *        used.
+ *
+ * \tparam _AesGcmType The AES-GCM implementation to test.
+ *
+ * \param withNonStdIv Whether to include the test vectors with an IV that
+ *                     is not 96-bit long (not supported by the SGX SDK).
+ *
+ * \return True if all tests passed.
+ */
+template<typename _AesGcmType>
+inline bool AesGcmKnownAnswerTest(bool withNonStdIv = true)
+{
+	using namespace AesGcmKatImpl;
+	using KeyType = typename _AesGcmType::KeyType;
+
+	for (const AesGcmKatVector& vec : GetAesGcmKatVectors())
+	{
+		const std::vector<uint8_t> keyBytes = HexToBytes(vec.m_key);
+		const std::vector<uint8_t> iv = HexToBytes(vec.m_iv);
+		const std::vector<uint8_t> aad = HexToBytes(vec.m_aad);
+		const std::vector<uint8_t> plain = HexToBytes(vec.m_plain);
+		const std::vector<uint8_t> cipher = HexToBytes(vec.m_cipher);
+		const std::vector<uint8_t> tag = HexToBytes(vec.m_tag);
+
+		if (
+			(vec.m_keyBitSize != _AesGcmType::sk_keyBitSize) ||
+			(!withNonStdIv && iv.size() != 12)
+		)
+		{
+			continue;
+		}
+
+		KeyType key;
+		std::memcpy(key.data(), keyBytes.data(), keyBytes.size());
+
+		try
+		{
+			_AesGcmType cryptor(key);
+			std::vector<uint8_t> data;
+			std::array<uint8_t, 16> outTag;
+
+			// single AAD
+			data = plain;
+			outTag = cryptor.EncryptInPlace(
+				iv.data(), iv.size(),
+				aad.data(), aad.size(),
+				data.data(), data.size()
+			);
+			if (
+				(data != cipher) ||
+				(std::memcmp(outTag.data(), tag.data(), tag.size()) != 0)
+			)
+			{
+				return false;
+			}
+			cryptor.DecryptInPlace(
+				iv.data(), iv.size(),
+				aad.data(), aad.size(),
+				data.data(), data.size(),
+				tag.data()
+			);
+			if (data != plain)
+			{
+				return false;
+			}
+
+			// segmented AAD, split at an odd position
+			const size_t split = aad.size() / 3;
+			data = plain;
+			outTag = cryptor.EncryptInPlace(
+				iv.data(), iv.size(),
+				{
+					{ aad.data(), split },
+					{ aad.data() + split, aad.size() - split },
+				},
+				data.data(), data.size()
+			);
+			if (
+				(data != cipher) ||
+				(std::memcmp(outTag.data(), tag.data(), tag.size()) != 0)
+			)
+			{
+				return false;
+			}
+			cryptor.DecryptInPlace(
+				iv.data(), iv.size(),
+				{
+					{ aad.data(), split },
+					{ aad.data() + split, aad.size() - split },
+				},
+				data.data(), data.size(),
+				tag.data()
+			);
+			if (data != plain)
+			{
+				return false;
+			}
+
+			// modified tag must be rejected
+			std::vector<uint8_t> badTag = tag;
+			badTag[0] ^= 0x01;
+			data = cipher;
+			bool isRejected = false;
+			try
+			{
+				cryptor.DecryptInPlace(
+					iv.data(), iv.size(),
+					aad.data(), aad.size(),
+					data.data(), data.size(),
+					badTag.data()
+				);
+			}
+			catch (...)
+			{
+				isRejected = true;
+			}
+			if (!isRejected)
+			{
+				return false;
+			}
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+} // namespace Platform
+} // namespace Common
+} // namespace DecentEnclave
@@ -9,13 +9,18 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <mbedTLScpp/Tls.hpp>
 #include <SimpleObjects/Internal/make_unique.hpp>
 #include <SimpleSysIO/StreamSocketBase.hpp>
 
+#include "AsyncSocket.hpp"
 #include "Exceptions.hpp"
 #include "Internal/SimpleObj.hpp"
 #include "Internal/SimpleSysIO.hpp"
@@ -36,65 +41,95 @@ public: // static members:
 
 	using UnderlyingType = SysIO::StreamSocketBase;
 
+	/**
+	 * \brief Default size of the read-ahead buffer; enough for a full TLS
+	 *        record (16 KiB of plain text, plus header and expansion).
+	 */
+	static constexpr size_t sk_defaultReadAheadSize = 17 * 1024;
+
 public:
 
+	/**
+	 * \param readAheadSize Up to how many bytes are read from the underlying
+	 *                      socket at once, and then served to mbedTLS's
+	 *                      (usually small) reads; 0 disables the read-ahead.
+	 */
 	TlsNonblockingSocket(
 		std::unique_ptr<UnderlyingType> socket,
-		bool asyncMode = false
+		bool asyncMode = false,
+		size_t readAheadSize = sk_defaultReadAheadSize
 	) :
 		m_socket(std::move(socket)),
 		m_asyncMode(asyncMode),
+		m_readAheadSize(readAheadSize),
 		m_recvBuf(),
 		m_recvBufPos(0),
-		m_recvAsyncRequested(0)
+		m_recvBufEnd(0),
+		m_recvAsyncRequested(0),
+		m_isCapturingSend(false),
+		m_sendCaptureBuf(),
+		m_sentSize(0),
+		m_recvdSize(0)
 	{}
 
 	~TlsNonblockingSocket() = default;
 
 	int Send(const unsigned char *buf, size_t len)
 	{
-		return static_cast<int>(
-			SysIO::StreamSocketRaw::Send(*m_socket, buf, len)
-		);
+		if (m_isCapturingSend)
+		{
+			// the data will be sent by the caller of `EndSendCapture`
+			m_sendCaptureBuf.insert(m_sendCaptureBuf.end(), buf, buf + len);
+			return static_cast<int>(len);
+		}
+
+		const size_t sentSize =
+			SysIO::StreamSocketRaw::Send(*m_socket, buf, len);
+		m_sentSize += sentSize;
+		return static_cast<int>(sentSize);
 	}
 
 	int Recv(unsigned char *buf, size_t len)
 	{
-		if (!m_recvBuf.empty())
+		if (m_recvBufPos < m_recvBufEnd)
 		{
 			// The recv buffer is not empty
 			// consume the buffer first
-			size_t copyLen = std::min(len, m_recvBuf.size() - m_recvBufPos);
-			std::copy(
-				m_recvBuf.begin() + m_recvBufPos,
-				m_recvBuf.begin() + m_recvBufPos + copyLen,
-				buf
-			);
-			m_recvBufPos += copyLen;
-
-			// if the buffer is all consumed, clear the buffer
-			if (m_recvBufPos >= m_recvBuf.size())
-			{
-				m_recvBuf.clear();
-				m_recvBufPos = 0;
-			}
-
-			// return the number of bytes consumed
-			return static_cast<int>(copyLen);
+			return ConsumeRecvBuf(buf, len);
 		}
 		else if (!m_asyncMode)
 		{
 			// The recv buffer is empty
 			// and the socket is not in async mode (blocking mode)
-			return static_cast<int>(
-				SysIO::StreamSocketRaw::Recv(*m_socket, buf, len)
+			if (len >= m_readAheadSize)
+			{
+				// large enough to be read directly
+				const size_t recvdSize =
+					SysIO::StreamSocketRaw::Recv(*m_socket, buf, len);
+				m_recvdSize += recvdSize;
+				return static_cast<int>(recvdSize);
+			}
+
+			// read ahead, so the following reads (e.g., the record body
+			// after its header) are served without touching the socket
+			if (m_recvBuf.size() < m_readAheadSize)
+			{
+				m_recvBuf.resize(m_readAheadSize);
+			}
+			m_recvBufPos = 0;
+			m_recvBufEnd = SysIO::StreamSocketRaw::Recv(
+				*m_socket,
+				m_recvBuf.data(),
+				m_readAheadSize
 			);
+			m_recvdSize += m_recvBufEnd;
+			return ConsumeRecvBuf(buf, len);
 		}
 		else
 		{
 			// The recv buffer is empty
 			// and the socket is in async mode
-			m_recvAsyncRequested = len;
+			m_recvAsyncRequested = std::max(len, m_readAheadSize);
 			return MBEDTLS_ERR_SSL_WANT_READ;
 		}
 	}
@@ -108,6 +143,8 @@ public:
 	{
 		m_recvBuf.swap(buf);
 		m_recvBufPos = 0;
+		m_recvBufEnd = m_recvBuf.size();
+		m_recvdSize += m_recvBufEnd;
 	}
 
 	UnderlyingType& GetUnderlyingSocket()
@@ -120,14 +157,83 @@ public:
 		return m_recvAsyncRequested;
 	}
 
+	/**
+	 * \brief Number of bytes the underlying socket has accepted from the
+	 *        blocking sends (i.e., not the captured ones) so far.
+	 */
+	uint64_t GetSentSize() const
+	{
+		return m_sentSize;
+	}
+
+	/**
+	 * \brief Number of bytes received from the underlying socket so far.
+	 */
+	uint64_t GetRecvdSize() const
+	{
+		return m_recvdSize;
+	}
+
+	/**
+	 * \brief Start collecting the data sent by mbedTLS, instead of sending
+	 *        it to the underlying socket.
+	 */
+	void StartSendCapture()
+	{
+		m_isCapturingSend = true;
+		m_sendCaptureBuf.clear();
+	}
+
+	/**
+	 * \brief Stop collecting the data sent by mbedTLS, and get the data
+	 *        collected since `StartSendCapture`.
+	 */
+	std::vector<uint8_t> EndSendCapture()
+	{
+		m_isCapturingSend = false;
+		std::vector<uint8_t> res;
+		res.swap(m_sendCaptureBuf);
+		return res;
+	}
+
 private:
 
+	int ConsumeRecvBuf(unsigned char *buf, size_t len)
+	{
+		size_t copyLen = std::min(len, m_recvBufEnd - m_recvBufPos);
+		std::copy(
+			m_recvBuf.begin() + m_recvBufPos,
+			m_recvBuf.begin() + m_recvBufPos + copyLen,
+			buf
+		);
+		m_recvBufPos += copyLen;
+
+		// if the buffer is all consumed, reset the cursor
+		// (the storage is kept for the next read-ahead)
+		if (m_recvBufPos >= m_recvBufEnd)
+		{
+			m_recvBufPos = 0;
+			m_recvBufEnd = 0;
+		}
+
+		// return the number of bytes consumed
+		return static_cast<int>(copyLen);
+	}
+
 	std::unique_ptr<UnderlyingType> m_socket;
 	bool m_asyncMode;
+	size_t m_readAheadSize;
 
 	std::vector<uint8_t> m_recvBuf;
 	size_t m_recvBufPos;
+	size_t m_recvBufEnd;
 	size_t m_recvAsyncRequested;
+
+	bool m_isCapturingSend;
+	std::vector<uint8_t> m_sendCaptureBuf;
+
+	uint64_t m_sentSize;
+	uint64_t m_recvdSize;
 }; // class TlsNonblockingSocket
 
 
@@ -162,76 +268,319 @@ private:
 }; // class TlsSocketWrapper
 
 
-inline void TlsRecvOrAsyncRecv(
-	std::shared_ptr<mbedTLScpp::Tls<TlsSocketWrapper> > tls,
-	std::shared_ptr<TlsNonblockingSocket> socket,
-	size_t bufSize,
-	typename SysIO::StreamSocketBase::AsyncRecvCallback callback
+/**
+ * \brief Same as `Tls::RecvData`, except that TLS 1.3 session tickets
+ *        received on the way are not reported to the caller as errors;
+ *        `hasNewSessTkt` is set instead.
+ */
+inline int TlsRecvData(
+	mbedTLScpp::Tls<TlsSocketWrapper>& tls,
+	void* buf,
+	size_t len,
+	bool& hasNewSessTkt
 )
 {
-	std::vector<uint8_t> buf(bufSize);
-	int recvRet = tls->RecvData(buf.data(), buf.size());
-	if (recvRet >= 0)
-	{
-		// Received data
-		buf.resize(static_cast<size_t>(recvRet));
-		callback(std::move(buf), false);
-	}
-	else if (recvRet == MBEDTLS_ERR_SSL_WANT_READ)
-	{
-		// Need to receive more data
-		size_t tlsRequested = socket->GetRecvAsyncRequested();
-
-		std::weak_ptr<mbedTLScpp::Tls<TlsSocketWrapper> > tlsWeak = tls;
-		std::weak_ptr<TlsNonblockingSocket> socketWeak = socket;
-		auto& underlyingSocket = socket->GetUnderlyingSocket();
-
-		SysIO::StreamSocketRaw::AsyncRecv(
-			underlyingSocket,
-			tlsRequested,
-			[
-				socketWeak,
-				tlsWeak,
-				bufSize,
-				callback
-			](std::vector<uint8_t> buf, bool hasErrorOccurred)
+	int recvRet = tls.RecvData(buf, len);
+#ifdef MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+	while (recvRet == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET)
+	{
+		hasNewSessTkt = true;
+		recvRet = tls.RecvData(buf, len);
+	}
+#else
+	(void)hasNewSessTkt;
+#endif // MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+	return recvRet;
+}
+
+
+/**
+ * \brief The state machine of the async receive of a `TlsSocket`.
+ *        There is one per socket, so the decrypted data buffer is reused
+ *        across receives, and every `WANT_READ` is handled by a loop
+ *        rather than by recursion, including when the underlying socket,
+ *        or the caller's callback (by starting the next receive), calls
+ *        back synchronously.
+ */
+class TlsAsyncRecvState :
+	public std::enable_shared_from_this<TlsAsyncRecvState>
+{
+public: // static members:
+
+	using TlsType = mbedTLScpp::Tls<TlsSocketWrapper>;
+	using VecCallback = SysIO::StreamSocketBase::AsyncRecvCallback;
+	using ViewCallback =
+		std::function<void(const uint8_t*, size_t, bool)>;
+
+public:
+
+	TlsAsyncRecvState(
+		std::weak_ptr<TlsType> tls,
+		std::weak_ptr<TlsNonblockingSocket> socket
+	) :
+		m_tls(std::move(tls)),
+		m_socket(std::move(socket)),
+		m_mutex(),
+		m_isRunning(false),
+		m_hasRequest(false),
+		m_reqSize(0),
+		m_reqVecCallback(),
+		m_reqViewCallback(),
+		m_hasCurr(false),
+		m_currSize(0),
+		m_currVecCallback(),
+		m_currViewCallback(),
+		m_isWaiting(false),
+		m_hasRecvData(false),
+		m_recvData(),
+		m_recvHasError(false),
+		m_outBuf(),
+		m_hasNewSessTkt(false)
+	{}
+
+	~TlsAsyncRecvState() = default;
+
+	/**
+	 * \brief Whether a TLS 1.3 session ticket has been received by the
+	 *        async receives.
+	 */
+	bool HasNewSessTkt() const
+	{
+		return m_hasNewSessTkt.load();
+	}
+
+	/**
+	 * \brief Start receiving up to `bufSize` bytes; the callback receives
+	 *        a vector holding exactly the received bytes.
+	 */
+	void Start(size_t bufSize, VecCallback callback)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_hasRequest = true;
+		m_reqSize = bufSize;
+		m_reqVecCallback = std::move(callback);
+		m_reqViewCallback = ViewCallback();
+		RunIfIdle(lock);
+	}
+
+	/**
+	 * \brief Start receiving up to `bufSize` bytes; the callback receives
+	 *        a view of the received bytes, which is valid only during the
+	 *        call back, so nothing is allocated for the delivery.
+	 */
+	void Start(size_t bufSize, ViewCallback callback)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_hasRequest = true;
+		m_reqSize = bufSize;
+		m_reqVecCallback = VecCallback();
+		m_reqViewCallback = std::move(callback);
+		RunIfIdle(lock);
+	}
+
+private:
+
+	void OnUnderlyingRecv(std::vector<uint8_t> data, bool hasErrorOccurred)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_hasRecvData = true;
+		m_recvData.swap(data);
+		m_recvHasError = hasErrorOccurred;
+		RunIfIdle(lock);
+	}
+
+	void RunIfIdle(std::unique_lock<std::mutex>& lock)
+	{
+		if (m_isRunning)
+		{
+			// it will be picked up by the running loop
+			return;
+		}
+		m_isRunning = true;
+		Run(lock);
+	}
+
+	/**
+	 * \brief The loop driving the receives; it's entered with the lock held,
+	 *        and returns (with the lock held) once it has to wait for a call
+	 *        back.
+	 */
+	void Run(std::unique_lock<std::mutex>& lock)
+	{
+		while (true)
+		{
+			bool hasError = false;
+			if (!m_hasCurr)
 			{
-				auto tls = tlsWeak.lock();
-				auto socket = socketWeak.lock();
-				if (
-					!hasErrorOccurred &&
-					tls != nullptr &&
-					socket != nullptr
-				)
+				if (!m_hasRequest)
+				{
+					// nothing more to receive
+					m_isRunning = false;
+					return;
+				}
+				m_hasRequest = false;
+				m_hasCurr = true;
+				m_currSize = m_reqSize;
+				m_currVecCallback = std::move(m_reqVecCallback);
+				m_currViewCallback = std::move(m_reqViewCallback);
+			}
+			else if (m_isWaiting)
+			{
+				if (!m_hasRecvData)
+				{
+					// wait for the underlying socket to call back
+					m_isRunning = false;
+					return;
+				}
+				m_isWaiting = false;
+				m_hasRecvData = false;
+				hasError = m_recvHasError;
+
+				auto socket = m_socket.lock();
+				if (!hasError && (socket != nullptr))
 				{
-					socket->ResetRecvBuf(std::move(buf));
-					TlsRecvOrAsyncRecv(tls, socket, bufSize, callback);
+					// the underlying socket's buffer is adopted as is
+					socket->ResetRecvBuf(std::move(m_recvData));
 				}
-				else
+				m_recvData = std::vector<uint8_t>();
+			}
+			lock.unlock();
+
+			int recvRet = MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+			auto tls = m_tls.lock();
+			auto socket = m_socket.lock();
+			if (!hasError && (tls != nullptr) && (socket != nullptr))
+			{
+				if (m_outBuf.size() < m_currSize)
 				{
-					callback(std::vector<uint8_t>(), true);
+					m_outBuf.resize(m_currSize);
+				}
+				bool hasNewSessTkt = false;
+				recvRet = TlsRecvData(
+					*tls,
+					m_outBuf.data(),
+					m_currSize,
+					hasNewSessTkt
+				);
+				if (hasNewSessTkt)
+				{
+					m_hasNewSessTkt.store(true);
 				}
 			}
-		);
-	}
-	else
-	{
-		// Error occurred
-		callback(std::vector<uint8_t>(), true);
+
+			if (recvRet == MBEDTLS_ERR_SSL_WANT_READ)
+			{
+				// Need to receive more data;
+				// the underlying socket may call back before this returns,
+				// and then the loop continues with that data
+				lock.lock();
+				m_isWaiting = true;
+				lock.unlock();
+
+				auto self = shared_from_this();
+				try
+				{
+					SysIO::StreamSocketRaw::AsyncRecv(
+						socket->GetUnderlyingSocket(),
+						socket->GetRecvAsyncRequested(),
+						[self](std::vector<uint8_t> buf, bool hasErrorOccurred)
+						{
+							self->OnUnderlyingRecv(
+								std::move(buf),
+								hasErrorOccurred
+							);
+						}
+					);
+					lock.lock();
+					continue;
+				}
+				catch (...)
+				{
+					lock.lock();
+					m_isWaiting = false;
+					lock.unlock();
+				}
+			}
+
+			// Received data, or error occurred
+			const bool isReceived = (recvRet >= 0);
+			const size_t recvSize =
+				isReceived ? static_cast<size_t>(recvRet) : 0;
+
+			lock.lock();
+			m_hasCurr = false;
+			VecCallback vecCallback = std::move(m_currVecCallback);
+			ViewCallback viewCallback = std::move(m_currViewCallback);
+			m_currVecCallback = VecCallback();
+			m_currViewCallback = ViewCallback();
+			lock.unlock();
+
+			// the callback may start the next receive,
+			// which is then picked up by this loop
+			if (viewCallback)
+			{
+				viewCallback(m_outBuf.data(), recvSize, !isReceived);
+			}
+			else if (vecCallback)
+			{
+				vecCallback(
+					std::vector<uint8_t>(
+						m_outBuf.begin(),
+						m_outBuf.begin() + recvSize
+					),
+					!isReceived
+				);
+			}
+
+			lock.lock();
+		}
 	}
-}
+
+	std::weak_ptr<TlsType> m_tls;
+	std::weak_ptr<TlsNonblockingSocket> m_socket;
+
+	std::mutex m_mutex;
+	bool m_isRunning;
+
+	// the receive requested by the caller
+	bool m_hasRequest;
+	size_t m_reqSize;
+	VecCallback m_reqVecCallback;
+	ViewCallback m_reqViewCallback;
+
+	// the receive being processed
+	bool m_hasCurr;
+	size_t m_currSize;
+	VecCallback m_currVecCallback;
+	ViewCallback m_currViewCallback;
+	bool m_isWaiting;
+
+	// the data delivered by the underlying socket
+	bool m_hasRecvData;
+	std::vector<uint8_t> m_recvData;
+	bool m_recvHasError;
+
+	// the decrypted data, reused across receives
+	std::vector<uint8_t> m_outBuf;
+
+	std::atomic<bool> m_hasNewSessTkt;
+}; // class TlsAsyncRecvState
 
 } // namespace Internal
 
 
 class TlsSocket:
-	public Internal::SysIO::StreamSocketBase
+	public Internal::SysIO::StreamSocketBase,
+	public AsyncSendSocketIntf
 {
 public: //static members:
 
 	using Base = Internal::SysIO::StreamSocketBase;
+	using AsyncSendBase = AsyncSendSocketIntf;
 	using SharedSocketType = Internal::TlsNonblockingSocket;
 	using TlsType = mbedTLScpp::Tls<Internal::TlsSocketWrapper>;
+	using SessionPtrType = std::shared_ptr<const mbedTLScpp::TlsSession>;
+	using AsyncRecvViewCallback = Internal::TlsAsyncRecvState::ViewCallback;
 
 public:
 	TlsSocket(
@@ -250,14 +599,36 @@ public:
 					Internal::TlsSocketWrapper
 				>(m_socket)
 			)
-		)
+		),
+		m_asyncRecv(
+			std::make_shared<Internal::TlsAsyncRecvState>(m_tls, m_socket)
+		),
+		m_asyncSend(MakeAsyncSendQueue(m_socket)),
+		m_hasNewSessTkt(false),
+		m_isSessionExported(false),
+		m_isSendBroken(false)
 	{}
 
-	~TlsSocket() = default;
+	~TlsSocket()
+	{
+		m_asyncSend->Close();
+	}
 
 
+	/**
+	 * \brief Must not be called until all of the pending async sends have
+	 *        completed, since their records have been sealed already and
+	 *        must reach the peer first.
+	 */
 	virtual size_t SendRaw(const void* buf, size_t len) override
 	{
+		if (!m_asyncSend->IsIdle())
+		{
+			throw Exception(
+				"TlsSocket::SendRaw - There are async sends pending"
+			);
+		}
+		CheckSendNotBroken();
 		return static_cast<size_t>(m_tls->SendData(buf, len));
 	}
 
@@ -265,7 +636,13 @@ public:
 	virtual size_t RecvRaw(void* buf, size_t len) override
 	{
 		m_socket->SetAsyncMode(false);
-		int tlsRet = m_tls->RecvData(buf, len);
+		int tlsRet = Internal::TlsRecvData(*m_tls, buf, len, m_hasNewSessTkt);
+		if (tlsRet == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
+		{
+			throw ConnectionClosedException(
+				"TlsSocket::RecvRaw - The peer has closed the connection"
+			);
+		}
 		return tlsRet >= 0 ?
 			static_cast<size_t>(tlsRet) :
 			throw Exception(
@@ -279,18 +656,188 @@ public:
 	) override
 	{
 		m_socket->SetAsyncMode(true);
-		Internal::TlsRecvOrAsyncRecv(
-			m_tls,
-			m_socket,
-			bufSize,
-			std::move(callback)
+		m_asyncRecv->Start(bufSize, std::move(callback));
+	}
+
+	/**
+	 * \brief Same as `AsyncRecvRaw`, but the callback receives a view of
+	 *        the received data, which is only valid during the call back;
+	 *        so no buffer is allocated for each receive.
+	 */
+	void AsyncRecvRawView(
+		size_t bufSize,
+		AsyncRecvViewCallback callback
+	)
+	{
+		m_socket->SetAsyncMode(true);
+		m_asyncRecv->Start(bufSize, std::move(callback));
+	}
+
+	/**
+	 * \brief The data is encrypted right away, and the resulting records
+	 *        are sent asynchronously if the underlying socket supports it
+	 *        (see `AsyncSend`).
+	 *        If the encryption fails part-way, the records sealed so far
+	 *        are dropped, so the peer would see a gap in the record
+	 *        sequence; all of the later sends on this socket fail then.
+	 */
+	virtual void AsyncSendRaw(
+		std::vector<uint8_t> data,
+		typename AsyncSendBase::AsyncSendCallback callback
+	) override
+	{
+		std::vector<uint8_t> records;
+		try
+		{
+			CheckSendNotBroken();
+		}
+		catch (...)
+		{
+			callback(true);
+			return;
+		}
+
+		try
+		{
+			m_socket->StartSendCapture();
+			size_t sentSize = 0;
+			while (sentSize < data.size())
+			{
+				sentSize += static_cast<size_t>(m_tls->SendData(
+					data.data() + sentSize,
+					data.size() - sentSize
+				));
+			}
+			records = m_socket->EndSendCapture();
+		}
+		catch (...)
+		{
+			m_socket->EndSendCapture();
+			m_isSendBroken = true;
+			callback(true);
+			return;
+		}
+
+		m_asyncSend->Push(std::move(records), std::move(callback));
+	}
+
+	/**
+	 * \brief Number of bytes (of TLS records) the underlying socket has
+	 *        accepted from the blocking sends so far; e.g., to tell whether
+	 *        anything has left this socket before a send failed.
+	 */
+	uint64_t GetSentSize() const
+	{
+		return m_socket->GetSentSize();
+	}
+
+	/**
+	 * \brief Number of bytes (of TLS records) received from the underlying
+	 *        socket so far; e.g., to tell whether anything has come from
+	 *        the peer before a receive failed.
+	 */
+	uint64_t GetRecvdSize() const
+	{
+		return m_socket->GetRecvdSize();
+	}
+
+	/**
+	 * \brief Whether the session can be exported by `ExportSession`, i.e.,
+	 *        it hasn't been exported yet, and, under TLS 1.3, a session
+	 *        ticket has been received (which only comes after the
+	 *        handshake, usually along with the first response).
+	 */
+	bool IsSessionReady() const
+	{
+		if (m_isSessionExported)
+		{
+			return false;
+		}
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+		if (
+			mbedtls_ssl_get_version_number(m_tls->Get()) ==
+				MBEDTLS_SSL_VERSION_TLS1_3
+		)
+		{
+			return m_hasNewSessTkt || m_asyncRecv->HasNewSessTkt();
+		}
+#endif // defined(MBEDTLS_SSL_PROTO_TLS1_3)
+		return true;
+	}
+
+	/**
+	 * \brief Export a copy of the TLS session, so it can be resumed by a
+	 *        later connection; mbedTLS only allows it once per connection,
+	 *        so it should be called once the handshake is done and, under
+	 *        TLS 1.3, the session ticket has been received.
+	 *
+	 * \return The session, or `nullptr` if it's not ready (see
+	 *         `IsSessionReady`).
+	 */
+	SessionPtrType ExportSession()
+	{
+		if (!IsSessionReady())
+		{
+			return nullptr;
+		}
+		// the attempt counts, even if it fails
+		m_isSessionExported = true;
+
+		auto session = std::make_shared<mbedTLScpp::TlsSession>();
+		mbedTLScpp::CheckMbedTlsIntRetVal(
+			mbedtls_ssl_get_session(m_tls->Get(), session->Get()),
+			"mbedtls_ssl_get_session",
+			"DecentEnclave::Common::TlsSocket::ExportSession"
 		);
+		return session;
 	}
 
 private:
 
+	void CheckSendNotBroken() const
+	{
+		if (m_isSendBroken)
+		{
+			throw Exception(
+				"TlsSocket - A previous async send has failed part-way, "
+				"so no more data can be sent"
+			);
+		}
+	}
+
+	static std::shared_ptr<Internal::AsyncSendQueue> MakeAsyncSendQueue(
+		std::weak_ptr<SharedSocketType> socketWeak
+	)
+	{
+		return std::make_shared<Internal::AsyncSendQueue>(
+			[socketWeak](
+				std::vector<uint8_t> data,
+				Internal::AsyncSendQueue::Callback callback
+			)
+			{
+				auto socket = socketWeak.lock();
+				if (socket == nullptr)
+				{
+					throw Exception(
+						"TlsSocket::AsyncSendRaw - The socket is closed"
+					);
+				}
+				AsyncSend(
+					socket->GetUnderlyingSocket(),
+					std::move(data),
+					std::move(callback)
+				);
+			}
+		);
+	}
+
 	std::shared_ptr<SharedSocketType> m_socket;
 	std::shared_ptr<TlsType> m_tls;
+	std::shared_ptr<Internal::TlsAsyncRecvState> m_asyncRecv;
+	std::shared_ptr<Internal::AsyncSendQueue> m_asyncSend;
+	bool m_hasNewSessTkt;
+	bool m_isSessionExported;
+	bool m_isSendBroken;
 
 }; // class TlsSocket
 
@@ -16,6 +16,7 @@
 #include "../Common/Platform/Print.hpp"
 
 #include "../Trusted/DecentLambdaSvr.hpp"
+#include "../Trusted/DecentTlsSessTktMgr.hpp"
 #include "../Trusted/HeartbeatEmitterMgr.hpp"
 #include "../Trusted/Sgx/ComponentConnection.hpp"
 
@@ -34,15 +35,28 @@ extern "C" sgx_status_t ecall_decent_lambda_handler(
 
 	std::unique_ptr<StreamSocket> sock =
 		Obj::Internal::make_unique<StreamSocket>(realSockPtr);
+	// owned by the TLS socket below
+	StreamSocket& rawSock = *sock;
 
 	try
 	{
 		const auto& svrConfig = LambdaServerConfig::GetInstance();
 
-		auto tlsCfg = DecentTlsConfig::MakeTlsConfig(
+		// shared by all connections, so tickets issued by one of them
+		// can be accepted by any other
+		static const std::shared_ptr<DecentTlsSessTktMgr> sk_tktMgr =
+			svrConfig.m_sessTktKeyName.empty() ?
+				nullptr :
+				DecentTlsSessTktMgr::FromSKeyring(
+					svrConfig.m_sessTktKeyName
+				);
+
+		auto tlsCfg = DecentTlsConfig::GetCachedTlsConfig(
 			true,
 			svrConfig.m_keyName,
-			svrConfig.m_certName
+			svrConfig.m_certName,
+			sk_tktMgr,
+			svrConfig.m_tlsPolicy
 		);
 		std::unique_ptr<TlsSocket> tlsSock =
 			Obj::Internal::make_unique<TlsSocket>(
@@ -51,12 +65,79 @@ extern "C" sgx_status_t ecall_decent_lambda_handler(
 				std::move(sock)
 			);
 
-		auto detMsgAdvRlp = tlsSock->SizedRecvBytes<std::vector<uint8_t> >();
+		if (!svrConfig.IsKeepAlive())
+		{
+			auto detMsgAdvRlp =
+				tlsSock->SizedRecvBytes<std::vector<uint8_t> >();
 
-		LambdaHandlerMgr::GetInstance().HandleCall(
-			std::move(tlsSock),
-			detMsgAdvRlp
-		);
+			LambdaHandlerMgr::GetInstance().HandleCall(
+				std::move(tlsSock),
+				detMsgAdvRlp
+			);
+		}
+		else
+		{
+			// keep-alive mode: serve the calls on this connection in order,
+			// until the peer closes it, it's idle for too long, a handler
+			// takes the socket, or the max number of calls is reached;
+			// calls pipelined by the peer simply wait in the stream
+			// valid as long as `conn` is not null
+			const TlsSocket& tlsSockRef = *tlsSock;
+			LambdaHandlerMgr::SocketPtrType conn = std::move(tlsSock);
+			for (
+				size_t callNum = 0;
+				(conn != nullptr) &&
+					((svrConfig.m_maxCallsPerConn == 0) ||
+					(callNum < svrConfig.m_maxCallsPerConn));
+				++callNum
+			)
+			{
+				const uint64_t recvdSize = tlsSockRef.GetRecvdSize();
+				std::vector<uint8_t> detMsgAdvRlp;
+				try
+				{
+					// the idle timeout only applies while waiting for the
+					// next call; once it starts coming, the rest of it is
+					// waited for as long as it takes
+					rawSock.SetNextRecvTimeout(svrConfig.m_idleTimeout);
+					detMsgAdvRlp =
+						conn->SizedRecvBytes<std::vector<uint8_t> >();
+					rawSock.SetNextRecvTimeout(0);
+				}
+				catch (const ConnectionClosedException&)
+				{
+					// the peer has closed the connection (close notify)
+					break;
+				}
+				catch (const std::exception& e)
+				{
+					if (rawSock.IsRecvTimedOut())
+					{
+						Platform::Print::StrDebug(
+							"Closing an idle Decent Lambda connection"
+						);
+					}
+					else if (tlsSockRef.GetRecvdSize() != recvdSize)
+					{
+						// something has come, but not a valid call
+						Platform::Print::StrErr(
+							std::string(
+								"Failed to receive a Decent Lambda call "
+								"(TLS or authentication error): "
+							) + e.what()
+						);
+					}
+					// otherwise, the peer has closed the connection
+					// without a word
+					break;
+				}
+
+				LambdaHandlerMgr::GetInstance().HandleCallOnConn(
+					conn,
+					detMsgAdvRlp
+				);
+			}
+		}
 	}
 	catch(const std::exception& e)
 	{
@@ -7,6 +7,17 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <sgx_error.h>
 
 #include "../Common/Internal/SimpleSysIO.hpp"
@@ -38,13 +49,239 @@ extern "C" sgx_status_t ocall_decent_endpoint_connect(
 	}
 }
 
+/**
+ * \brief Tracks the sockets with async operations in progress (sends, and
+ *        receives, including the ones left pending by a timeout), so a
+ *        socket disconnected by the enclave in the meantime is only
+ *        deleted once their handlers have run.
+ */
+class SSocketPendingOpTracker
+{
+public: // static members:
+
+	static SSocketPendingOpTracker& GetInstance()
+	{
+		static SSocketPendingOpTracker s_inst;
+		return s_inst;
+	}
+
+public:
+
+	SSocketPendingOpTracker() :
+		m_mutex(),
+		m_pendingMap()
+	{}
+
+	void AddOp(void* ptr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++(m_pendingMap[ptr].m_count);
+	}
+
+	/**
+	 * \return Whether the socket should be deleted now.
+	 */
+	bool OnOpDone(void* ptr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_pendingMap.find(ptr);
+		if (it == m_pendingMap.end())
+		{
+			return false;
+		}
+
+		--(it->second.m_count);
+		if (it->second.m_count > 0)
+		{
+			return false;
+		}
+
+		const bool isDisconnected = it->second.m_isDisconnected;
+		m_pendingMap.erase(it);
+		return isDisconnected;
+	}
+
+	/**
+	 * \return Whether the socket should be deleted now; otherwise, it's
+	 *         deleted once the last operation is done.
+	 */
+	bool OnDisconnect(void* ptr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_pendingMap.find(ptr);
+		if (it == m_pendingMap.end())
+		{
+			return true;
+		}
+
+		it->second.m_isDisconnected = true;
+		return false;
+	}
+
+private:
+
+	struct PendingOps
+	{
+		PendingOps() :
+			m_count(0),
+			m_isDisconnected(false)
+		{}
+
+		size_t m_count;
+		bool m_isDisconnected;
+	}; // struct PendingOps
+
+	std::mutex m_mutex;
+	std::unordered_map<void*, PendingOps> m_pendingMap;
+
+}; // class SSocketPendingOpTracker
+
+
+/**
+ * \brief Called once an async operation on the socket is done; the socket
+ *        is deleted if the enclave has disconnected it in the meantime.
+ */
+static
+inline
+void OnSSocketOpDone(void* ptr)
+{
+	using namespace DecentEnclave::Untrusted;
+	using _SSocketType = Config::EndpointsMgr::StreamSocketType;
+	if (SSocketPendingOpTracker::GetInstance().OnOpDone(ptr))
+	{
+		std::unique_ptr<_SSocketType> toDelete(
+			static_cast<_SSocketType*>(ptr)
+		);
+	}
+}
+
+
+/**
+ * \brief Threads dedicated to the async sends requested by the enclaves;
+ *        the sockets only have blocking sends, so a send to a slow peer
+ *        holds a thread until the kernel takes all of the data, and that
+ *        must not be an io_service thread, which would stop the async
+ *        receives and accepts in the meantime.
+ *        A new thread is started whenever all of them are busy, up to
+ *        `sk_maxWorkers`; beyond that, the sends wait for a free one.
+ *        Each send ends with an ecall, so, if the build defines the TCS
+ *        budget of the enclave (`DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM`, the
+ *        TCSNum of its configuration), the workers are bounded by it.
+ */
+class SSocketAsyncSendWorkers
+{
+public: // static members:
+
+#ifdef DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM
+	static constexpr size_t sk_maxWorkers = DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM;
+#else // DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM
+	static constexpr size_t sk_maxWorkers = 64;
+#endif // DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM
+
+	static SSocketAsyncSendWorkers& GetInstance()
+	{
+		static SSocketAsyncSendWorkers s_inst;
+		return s_inst;
+	}
+
+public:
+
+	SSocketAsyncSendWorkers() :
+		m_mutex(),
+		m_cond(),
+		m_jobs(),
+		m_workers(),
+		m_numIdle(0),
+		m_isStopped(false)
+	{}
+
+	~SSocketAsyncSendWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_cond.notify_all();
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	SSocketAsyncSendWorkers(const SSocketAsyncSendWorkers&) = delete;
+	SSocketAsyncSendWorkers& operator=(const SSocketAsyncSendWorkers&) = delete;
+
+	void Post(std::function<void()> job)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_isStopped)
+		{
+			throw DecentEnclave::Common::Exception(
+				"SSocketAsyncSendWorkers - The workers have been stopped"
+			);
+		}
+
+		// the thread is started first, so nothing is queued if that fails
+		if ((m_numIdle <= m_jobs.size()) && (m_workers.size() < sk_maxWorkers))
+		{
+			m_workers.emplace_back(&SSocketAsyncSendWorkers::Work, this);
+			++m_numIdle;
+		}
+		m_jobs.emplace_back(std::move(job));
+		m_cond.notify_one();
+	}
+
+private:
+
+	void Work()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			m_cond.wait(
+				lock,
+				[this](){ return m_isStopped || !m_jobs.empty(); }
+			);
+			if (m_isStopped)
+			{
+				return;
+			}
+
+			std::function<void()> job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			--m_numIdle;
+			lock.unlock();
+
+			// the jobs handle their own errors
+			job();
+
+			lock.lock();
+			++m_numIdle;
+		}
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::deque<std::function<void()> > m_jobs;
+	std::vector<std::thread> m_workers;
+	size_t m_numIdle;
+	bool m_isStopped;
+
+}; // class SSocketAsyncSendWorkers
+
+
 extern "C" void ocall_decent_ssocket_disconnect(
 	void* ptr
 )
 {
 	using namespace DecentEnclave::Untrusted;
 	using _SSocketType = Config::EndpointsMgr::StreamSocketType;
-	std::unique_ptr<_SSocketType> realPtr(static_cast<_SSocketType*>(ptr));
+	if (SSocketPendingOpTracker::GetInstance().OnDisconnect(ptr))
+	{
+		std::unique_ptr<_SSocketType> realPtr(
+			static_cast<_SSocketType*>(ptr)
+		);
+	}
 }
 
 extern "C" sgx_status_t ocall_decent_ssocket_send_raw(
@@ -103,28 +340,127 @@ extern "C" sgx_status_t ocall_decent_ssocket_recv_raw(
 }
 
 
+/**
+ * \brief Same as `ocall_decent_ssocket_recv_raw`, but gives up once no data
+ *        has come within `timeout_ms` milliseconds. The receive is made
+ *        async (so an io_service must be running the socket), and it's
+ *        still pending after a timeout, since it can't be cancelled; so the
+ *        socket must be closed then, and it's only deleted once the
+ *        receive is done (i.e., the peer has sent something or closed the
+ *        connection).
+ */
+extern "C" sgx_status_t ocall_decent_ssocket_recv_raw_timeout(
+	void* ptr,
+	size_t size,
+	uint64_t timeout_ms,
+	uint8_t** out_buf,
+	size_t* out_buf_size,
+	uint8_t* out_timed_out
+)
+{
+	using namespace DecentEnclave::Untrusted;
+	using namespace DecentEnclave::Common::Internal::SysIO;
+	using _SSocketType = Config::EndpointsMgr::StreamSocketType;
+	_SSocketType* realPtr = static_cast<_SSocketType*>(ptr);
+
+	try
+	{
+		// the promise outlives this call, in case the receive completes
+		// after the timeout
+		auto result = std::make_shared<std::promise<std::vector<uint8_t> > >();
+		std::future<std::vector<uint8_t> > future = result->get_future();
+		SSocketPendingOpTracker::GetInstance().AddOp(ptr);
+		try
+		{
+			StreamSocketRaw::AsyncRecv(
+				*realPtr,
+				size,
+				[ptr, result](std::vector<uint8_t> data, bool hasErrorOccurred)
+				{
+					if (hasErrorOccurred)
+					{
+						result->set_exception(std::make_exception_ptr(
+							DecentEnclave::Common::Exception(
+								"Failed to receive from the socket"
+							)
+						));
+					}
+					else
+					{
+						result->set_value(std::move(data));
+					}
+					OnSSocketOpDone(ptr);
+				}
+			);
+		}
+		catch (...)
+		{
+			SSocketPendingOpTracker::GetInstance().OnOpDone(ptr);
+			throw;
+		}
+
+		if (
+			future.wait_for(std::chrono::milliseconds(timeout_ms)) ==
+			std::future_status::timeout
+		)
+		{
+			*out_buf = nullptr;
+			*out_buf_size = 0;
+			*out_timed_out = 1;
+			return SGX_SUCCESS;
+		}
+
+		std::vector<uint8_t> data = future.get();
+		*out_buf = new uint8_t[data.size()];
+		std::copy(data.begin(), data.end(), *out_buf);
+		*out_buf_size = data.size();
+		*out_timed_out = 0;
+		return SGX_SUCCESS;
+	}
+	catch (const std::exception& e)
+	{
+		DecentEnclave::Common::Platform::Print::StrDebug(
+			"ocall_decent_ssocket_recv_raw_timeout failed with error " +
+			std::string(e.what())
+		);
+		return SGX_ERROR_UNEXPECTED;
+	}
+}
+
+
 static
 inline
 typename DecentEnclave::Common::Internal::
 	SysIO::StreamSocketBase::AsyncRecvCallback
 MakeAsyncRecvCallback(
+	void* ptr,
 	sgx_enclave_id_t enclave_id,
 	uint64_t handler_reg_id
 )
 {
 	return [
+				ptr,
 				enclave_id,
 				handler_reg_id
 			](std::vector<uint8_t> recvData, bool hasErrorOccurred) -> void
 		{
-			DECENTENCLAVE_SGX_ECALL_CHECK_ERROR_E_R(
-				ecall_decent_ssocket_async_recv_raw_callback,
-				enclave_id,
-				handler_reg_id,
-				recvData.data(),
-				recvData.size(),
-				hasErrorOccurred ? 1 : 0
-			);
+			try
+			{
+				DECENTENCLAVE_SGX_ECALL_CHECK_ERROR_E_R(
+					ecall_decent_ssocket_async_recv_raw_callback,
+					enclave_id,
+					handler_reg_id,
+					recvData.data(),
+					recvData.size(),
+					hasErrorOccurred ? 1 : 0
+				);
+			}
+			catch (...)
+			{
+				OnSSocketOpDone(ptr);
+				throw;
+			}
+			OnSSocketOpDone(ptr);
 		};
 }
 
@@ -143,11 +479,20 @@ extern "C" sgx_status_t ocall_decent_ssocket_async_recv_raw(
 
 	try
 	{
-		StreamSocketRaw::AsyncRecv(
-			*realPtr,
-			size,
-			MakeAsyncRecvCallback(enclave_id, handler_reg_id)
-		);
+		SSocketPendingOpTracker::GetInstance().AddOp(ptr);
+		try
+		{
+			StreamSocketRaw::AsyncRecv(
+				*realPtr,
+				size,
+				MakeAsyncRecvCallback(ptr, enclave_id, handler_reg_id)
+			);
+		}
+		catch (...)
+		{
+			SSocketPendingOpTracker::GetInstance().OnOpDone(ptr);
+			throw;
+		}
 		return SGX_SUCCESS;
 	}
 	catch (const std::exception& e)
@@ -159,3 +504,150 @@ extern "C" sgx_status_t ocall_decent_ssocket_async_recv_raw(
 		return SGX_ERROR_UNEXPECTED;
 	}
 }
+
+
+/**
+ * \brief Reports the completion of an async send to the enclave; the ecall
+ *        is retried for a while if the enclave is out of TCS (e.g., all of
+ *        them are taken by lambda calls), since the enclave's send queue
+ *        would otherwise wait for it forever.
+ */
+static
+inline
+void CallAsyncSendCallback(
+	sgx_enclave_id_t enclave_id,
+	uint64_t handler_reg_id,
+	bool hasErrorOccurred
+)
+{
+	static constexpr size_t sk_maxRetries = 10000;
+
+	sgx_status_t funcRet = SGX_ERROR_UNEXPECTED;
+	auto ecall = [&]()
+	{
+		return ecall_decent_ssocket_async_send_raw_callback(
+			enclave_id,
+			&funcRet,
+			handler_reg_id,
+			hasErrorOccurred ? 1 : 0
+		);
+	};
+
+	sgx_status_t edgeRet = ecall();
+	for (
+		size_t i = 0;
+		(edgeRet == SGX_ERROR_OUT_OF_TCS) && (i < sk_maxRetries);
+		++i
+	)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		edgeRet = ecall();
+	}
+
+	DECENTENCLAVE_CHECK_SGX_RUNTIME_ERROR(
+		edgeRet,
+		ecall_decent_ssocket_async_send_raw_callback
+	);
+	DECENTENCLAVE_CHECK_SGX_RUNTIME_ERROR(
+		funcRet,
+		ecall_decent_ssocket_async_send_raw_callback
+	);
+}
+
+
+static
+inline
+void PostAsyncSend(
+	void* ptr,
+	std::shared_ptr<std::vector<uint8_t> > data,
+	sgx_enclave_id_t enclave_id,
+	uint64_t handler_reg_id
+)
+{
+	using namespace DecentEnclave::Untrusted;
+	using namespace DecentEnclave::Common::Internal::SysIO;
+	using _SSocketType = Config::EndpointsMgr::StreamSocketType;
+
+	SSocketAsyncSendWorkers::GetInstance().Post(
+		[ptr, data, enclave_id, handler_reg_id]()
+		{
+			_SSocketType* realPtr = static_cast<_SSocketType*>(ptr);
+
+			bool hasErrorOccurred = false;
+			try
+			{
+				size_t sentSize = 0;
+				while (sentSize < data->size())
+				{
+					sentSize += StreamSocketRaw::Send(
+						*realPtr,
+						data->data() + sentSize,
+						data->size() - sentSize
+					);
+				}
+			}
+			catch (const std::exception&)
+			{
+				hasErrorOccurred = true;
+			}
+
+			try
+			{
+				CallAsyncSendCallback(
+					enclave_id,
+					handler_reg_id,
+					hasErrorOccurred
+				);
+			}
+			catch (const std::exception& e)
+			{
+				// the enclave will never know whether this send is done
+				DecentEnclave::Common::Platform::Print::StrErr(
+					"ecall_decent_ssocket_async_send_raw_callback "
+					"failed with error " + std::string(e.what())
+				);
+			}
+
+			OnSSocketOpDone(ptr);
+		}
+	);
+}
+
+
+extern "C" sgx_status_t ocall_decent_ssocket_async_send_raw(
+	void* ptr,
+	const uint8_t* in_buf,
+	size_t in_buf_size,
+	sgx_enclave_id_t enclave_id,
+	uint64_t handler_reg_id
+)
+{
+	try
+	{
+		// the enclave's buffer is only valid during this call
+		auto data = std::make_shared<std::vector<uint8_t> >(
+			in_buf,
+			in_buf + in_buf_size
+		);
+
+		SSocketPendingOpTracker::GetInstance().AddOp(ptr);
+		try
+		{
+			PostAsyncSend(ptr, data, enclave_id, handler_reg_id);
+		}
+		catch (...)
+		{
+			SSocketPendingOpTracker::GetInstance().OnOpDone(ptr);
+			throw;
+		}
+		return SGX_SUCCESS;
+	}
+	catch (const std::exception& e)
+	{
+		DecentEnclave::Common::Platform::Print::StrDebug(
+			"ocall_decent_ssocket_async_send_raw failed with error " +
+			std::string(e.what())
+		);
+		return SGX_ERROR_UNEXPECTED;
+	}
+}
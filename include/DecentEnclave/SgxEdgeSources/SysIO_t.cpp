@@ -46,3 +46,31 @@ extern "C" sgx_status_t ecall_decent_ssocket_async_recv_raw_callback(
 	}
 
 }
+
+extern "C" sgx_status_t ecall_decent_ssocket_async_send_raw_callback(
+	uint64_t handler_reg_id,
+	uint8_t has_error_occurred
+)
+{
+	using namespace DecentEnclave::Trusted::Sgx;
+
+	try
+	{
+		auto& handler = GetSSocketAsyncSendCallbackHandler();
+		handler.DispatchCallback(
+			handler_reg_id,
+			true, // dispose this registration entry after callback
+			has_error_occurred != 0
+		);
+		return SGX_SUCCESS;
+	}
+	catch(const std::exception& e)
+	{
+		DecentEnclave::Common::Platform::Print::StrDebug(
+			"ecall_decent_ssocket_async_send_raw_callback failed with error " +
+			std::string(e.what())
+		);
+		return SGX_ERROR_UNEXPECTED;
+	}
+
+}
@@ -105,6 +105,16 @@ sgx_status_t ocall_decent_ssocket_recv_raw(
 	size_t* out_buf_size
 );
 
+sgx_status_t ocall_decent_ssocket_recv_raw_timeout(
+	sgx_status_t* retval,
+	void* ptr,
+	size_t size,
+	uint64_t timeout_ms,
+	uint8_t** out_buf,
+	size_t* out_buf_size,
+	uint8_t* out_timed_out
+);
+
 sgx_status_t ocall_decent_ssocket_async_recv_raw(
 	sgx_status_t* retval,
 	void* ptr,
@@ -113,6 +123,15 @@ sgx_status_t ocall_decent_ssocket_async_recv_raw(
 	uint64_t handler_reg_id
 );
 
+sgx_status_t ocall_decent_ssocket_async_send_raw(
+	sgx_status_t* retval,
+	void* ptr,
+	const uint8_t* in_buf,
+	size_t in_buf_size,
+	sgx_enclave_id_t enclave_id,
+	uint64_t handler_reg_id
+);
+
 
 #ifdef __cplusplus
 }
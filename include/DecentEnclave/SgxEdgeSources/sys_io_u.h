@@ -22,6 +22,13 @@ sgx_status_t ecall_decent_ssocket_async_recv_raw_callback(
 	uint8_t has_error_occurred
 );
 
+sgx_status_t ecall_decent_ssocket_async_send_raw_callback(
+	sgx_enclave_id_t eid,
+	sgx_status_t* retval,
+	uint64_t handler_reg_id,
+	uint8_t has_error_occurred
+);
+
 uint64_t ocall_decent_untrusted_timestamp();
 uint64_t ocall_decent_untrusted_timestamp_ms();
 uint64_t ocall_decent_untrusted_timestamp_us();
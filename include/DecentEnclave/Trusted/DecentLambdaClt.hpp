@@ -16,6 +16,8 @@
 #include "../Common/TlsSocket.hpp"
 
 #include "ComponentConnection.hpp"
+#include "DecentTlsSessCache.hpp"
+#include "LambdaConnPool.hpp"
 
 
 namespace DecentEnclave
@@ -24,33 +26,185 @@ namespace Trusted
 {
 
 
-inline std::unique_ptr<DecentEnclave::Common::TlsSocket> MakeLambdaCall(
+/**
+ * \brief The TLS config of the calls to other components, cached (see
+ *        `DecentTlsConfig::GetCachedTlsConfig`); by default, it uses the
+ *        same policy as the lambda servers.
+ *
+ * \param policy `nullptr` keeps mbedTLS's defaults.
+ */
+inline std::shared_ptr<Common::DecentTlsConfig> GetLambdaCltTlsConfig(
+	const std::string& keyName,
+	const std::string& certName,
+	std::shared_ptr<const Common::DecentTlsPolicy> policy =
+		Common::DecentTlsPolicy::GetEnclaveToEnclave()
+)
+{
+	return Common::DecentTlsConfig::GetCachedTlsConfig(
+		false,
+		keyName,
+		certName,
+		nullptr,
+		std::move(policy)
+	);
+}
+
+
+inline std::unique_ptr<Common::TlsSocket> ConnectLambdaTls(
 	const std::string& componentName,
-	std::shared_ptr<Common::DecentTlsConfig> tlsConfig,
-	Common::DetMsg& msg
+	std::shared_ptr<Common::DecentTlsConfig> tlsConfig
 )
 {
 	using namespace DecentEnclave::Common;
 
-	static constexpr uint32_t sk_detMsgVer = 1;
-
 	auto socket = ComponentConnection::Connect(componentName);
 
-	std::unique_ptr<TlsSocket> tlsSock =
-		Internal::Obj::Internal::make_unique<TlsSocket>(
-			tlsConfig,
-			nullptr,
-			std::move(socket)
-		);
+	// offer the last session with this peer, if there is one;
+	// the server falls back to a full handshake if it can't resume it
+	return Internal::Obj::Internal::make_unique<TlsSocket>(
+		tlsConfig,
+		DecentTlsSessCache::GetInstance().Get(componentName),
+		std::move(socket)
+	);
+}
+
+inline void SendLambdaMsg(Common::TlsSocket& tlsSock, Common::DetMsg& msg)
+{
+	using namespace DecentEnclave::Common;
+
+	static constexpr uint32_t sk_detMsgVer = 1;
 
 	msg.get_Version() = Internal::Obj::UInt32(sk_detMsgVer);
 	auto msgAdvRlp = Internal::AdvRlp::GenericWriter::Write(msg);
 
-	tlsSock->SizedSendBytes(msgAdvRlp);
+	tlsSock.SizedSendBytes(msgAdvRlp);
+}
+
+/**
+ * \brief Keep the session of a connection in the session cache, so it can
+ *        be resumed by the next call to that component.
+ *        The session is only exported once per connection, and, under
+ *        TLS 1.3, only after its ticket has been received, which comes
+ *        along with the response; so this should be called once the
+ *        response has been read, and does nothing if the session isn't
+ *        ready (or has already been kept).
+ */
+inline void KeepLambdaSession(
+	const std::string& componentName,
+	Common::TlsSocket& tlsSock
+)
+{
+	Common::TlsSocket::SessionPtrType session;
+	try
+	{
+		session = tlsSock.ExportSession();
+	}
+	catch (const std::exception&)
+	{
+		// the next call to this component only does a full handshake
+		return;
+	}
+
+	if (session != nullptr)
+	{
+		DecentTlsSessCache::GetInstance().Put(
+			componentName,
+			std::move(session)
+		);
+	}
+}
+
+
+inline std::unique_ptr<DecentEnclave::Common::TlsSocket> MakeLambdaCall(
+	const std::string& componentName,
+	std::shared_ptr<Common::DecentTlsConfig> tlsConfig,
+	Common::DetMsg& msg
+)
+{
+	std::unique_ptr<Common::TlsSocket> tlsSock =
+		ConnectLambdaTls(componentName, tlsConfig);
+
+	SendLambdaMsg(*tlsSock, msg);
 
+	// the session is kept by the caller, with `KeepLambdaSession`,
+	// once the response has been read
 	return tlsSock;
 }
 
 
+/**
+ * \brief Same as `MakeLambdaCall`, but the connection is checked out from
+ *        `LambdaConnPool`, and goes back to the pool once the returned
+ *        handle is destroyed; so the response must be fully read by then.
+ *        The session of a reused connection is kept before the call is
+ *        sent, since the previous response has been read by then; the
+ *        caller may still call `KeepLambdaSession` after reading the
+ *        response, to have it kept sooner.
+ *        The peer must be serving in keep-alive mode.
+ *        If sending on an idle connection fails before any byte of the call
+ *        has been written (e.g., the peer has closed it in the meantime),
+ *        it's discarded and the call is retried on another connection;
+ *        otherwise, the error is thrown, since the call may not be
+ *        idempotent.
+ *        However, a connection closed by the peer is usually only noticed
+ *        when the response is read, since the send still succeeds, and
+ *        there is no way to check for a pending close_notify or EOF
+ *        without blocking (a receive that times out leaves the socket
+ *        unusable); so, if reading the response on a reused connection
+ *        throws `Common::ConnectionClosedException`, the caller should
+ *        retry the call, provided that it's idempotent.
+ *
+ * \param isReused Optional; set to whether the call was sent on a reused
+ *                 connection.
+ */
+inline LambdaConnHandle MakePooledLambdaCall(
+	const std::string& componentName,
+	std::shared_ptr<Common::DecentTlsConfig> tlsConfig,
+	Common::DetMsg& msg,
+	bool* isReused = nullptr
+)
+{
+	LambdaConnPool& pool = LambdaConnPool::GetInstance();
+	auto connect = [&componentName, &tlsConfig]()
+	{
+		return ConnectLambdaTls(componentName, tlsConfig);
+	};
+
+	while (true)
+	{
+		bool isConnReused = false;
+		LambdaConnHandle conn =
+			pool.CheckOut(componentName, connect, &isConnReused);
+		if (isConnReused)
+		{
+			KeepLambdaSession(componentName, *conn);
+		}
+
+		const uint64_t sentSize = conn->GetSentSize();
+		try
+		{
+			SendLambdaMsg(*conn, msg);
+		}
+		catch (const std::exception&)
+		{
+			conn.Invalidate();
+			// the call may not be idempotent, so it's only retried if none
+			// of it could have reached the peer
+			if (!isConnReused || (conn->GetSentSize() != sentSize))
+			{
+				throw;
+			}
+			continue;
+		}
+
+		if (isReused != nullptr)
+		{
+			*isReused = isConnReused;
+		}
+		return conn;
+	}
+}
+
+
 } // namespace Trusted
 } // namespace DecentEnclave
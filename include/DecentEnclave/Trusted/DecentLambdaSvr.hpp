@@ -6,6 +6,9 @@
 #pragma once
 
 
+#include <cstddef>
+#include <cstdint>
+
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -16,6 +19,7 @@
 #include <SimpleObjects/SimpleObjects.hpp>
 #include <SimpleSysIO/StreamSocketBase.hpp>
 
+#include "../Common/DecentTlsPolicy.hpp"
 #include "../Common/DeterministicMsg.hpp"
 #include "../Common/Exceptions.hpp"
 #include "../Common/Internal/SimpleObj.hpp"
@@ -30,6 +34,8 @@ namespace Trusted
 
 struct LambdaServerConfig
 {
+	static constexpr uint64_t sk_defaultIdleTimeout = 60 * 1000;
+
 	static const LambdaServerConfig& GetInstance(
 		const LambdaServerConfig* initVal = nullptr
 	)
@@ -43,18 +49,54 @@ struct LambdaServerConfig
 		return sk_config;
 	}
 
+	/**
+	 * \param sessTktKeyName Name of the SKeyring key used to seal TLS
+	 *                       session tickets; empty to disable session
+	 *                       tickets (i.e., session resumption).
+	 * \param maxCallsPerConn Max number of calls served on one connection
+	 *                        (keep-alive mode); 1 serves a single call per
+	 *                        connection, 0 serves until the peer closes it.
+	 * \param idleTimeout In keep-alive mode, how long (in milliseconds) a
+	 *                    connection may wait for the next call before it's
+	 *                    closed (once a call starts coming, the rest of it
+	 *                    is waited for without a limit); 0 keeps it open
+	 *                    until the peer closes it. It should be longer than
+	 *                    the time clients keep idle connections (see
+	 *                    `LambdaConnPoolConfig::m_maxIdleTime`).
+	 * \param tlsPolicy The cipher suites, groups and signature algorithms
+	 *                  accepted by the server; `nullptr` keeps mbedTLS's
+	 *                  defaults.
+	 */
 	LambdaServerConfig(
 		const std::string& keyName,
-		const std::string& certName
+		const std::string& certName,
+		const std::string& sessTktKeyName = std::string(),
+		size_t maxCallsPerConn = 1,
+		uint64_t idleTimeout = sk_defaultIdleTimeout,
+		std::shared_ptr<const Common::DecentTlsPolicy> tlsPolicy =
+			Common::DecentTlsPolicy::GetEnclaveToEnclave()
 	) :
 		m_keyName(keyName),
-		m_certName(certName)
+		m_certName(certName),
+		m_sessTktKeyName(sessTktKeyName),
+		m_maxCallsPerConn(maxCallsPerConn),
+		m_idleTimeout(idleTimeout),
+		m_tlsPolicy(std::move(tlsPolicy))
 	{}
 
 	~LambdaServerConfig() = default;
 
+	bool IsKeepAlive() const
+	{
+		return m_maxCallsPerConn != 1;
+	}
+
 	std::string m_keyName;
 	std::string m_certName;
+	std::string m_sessTktKeyName;
+	size_t m_maxCallsPerConn;
+	uint64_t m_idleTimeout;
+	std::shared_ptr<const Common::DecentTlsPolicy> m_tlsPolicy;
 }; // struct LambdaServerConfig
 
 
@@ -107,6 +149,19 @@ public:
 		SocketPtrType socket,
 		const std::vector<uint8_t>& msgAdvRlp
 	) const
+	{
+		HandleCallOnConn(socket, msgAdvRlp);
+	}
+
+	/**
+	 * \brief Same as `HandleCall`, but the socket stays with the caller,
+	 *        so more calls can be served on the same connection; it's
+	 *        `nullptr` afterwards if a handler has taken the ownership.
+	 */
+	void HandleCallOnConn(
+		SocketPtrType& socket,
+		const std::vector<uint8_t>& msgAdvRlp
+	) const
 	{
 		auto detMsg = Common::DetMsgParser().Parse(msgAdvRlp);
 		MsgTypeType msgType = MsgTypeType(
@@ -0,0 +1,122 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <mbedTLScpp/Tls.hpp>
+
+
+namespace DecentEnclave
+{
+namespace Trusted
+{
+
+
+/**
+ * \brief Client-side cache of TLS sessions, one per component (i.e., per
+ *        peer), so Decent lambda calls to a peer that has been called before
+ *        can resume the session instead of doing a full handshake.
+ */
+class DecentTlsSessCache
+{
+public: // static members:
+
+	using SessionType = mbedTLScpp::TlsSession;
+	using SessionPtrType = std::shared_ptr<const SessionType>;
+
+	static DecentTlsSessCache& GetInstance()
+	{
+		static DecentTlsSessCache s_inst;
+		return s_inst;
+	}
+
+public:
+
+	DecentTlsSessCache() :
+		m_sessMapMutex(),
+		m_sessMap(),
+		m_hitCount(0),
+		m_missCount(0)
+	{}
+
+	~DecentTlsSessCache() = default;
+
+	/**
+	 * \brief Get the cached session for the given component, or `nullptr`
+	 *        if there is none; the hit/miss counters are updated accordingly.
+	 */
+	SessionPtrType Get(const std::string& componentName)
+	{
+		SessionPtrType res;
+		{
+			std::lock_guard<std::mutex> lock(m_sessMapMutex);
+			auto it = m_sessMap.find(componentName);
+			if (it != m_sessMap.end())
+			{
+				res = it->second;
+			}
+		}
+
+		if (res != nullptr)
+		{
+			++m_hitCount;
+		}
+		else
+		{
+			++m_missCount;
+		}
+		return res;
+	}
+
+	void Put(const std::string& componentName, SessionPtrType session)
+	{
+		std::lock_guard<std::mutex> lock(m_sessMapMutex);
+		m_sessMap[componentName] = std::move(session);
+	}
+
+	void Remove(const std::string& componentName)
+	{
+		std::lock_guard<std::mutex> lock(m_sessMapMutex);
+		m_sessMap.erase(componentName);
+	}
+
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_sessMapMutex);
+		m_sessMap.clear();
+	}
+
+	uint64_t GetHitCount() const
+	{
+		return m_hitCount.load();
+	}
+
+	uint64_t GetMissCount() const
+	{
+		return m_missCount.load();
+	}
+
+private:
+
+	std::mutex m_sessMapMutex;
+	std::unordered_map<std::string, SessionPtrType> m_sessMap;
+
+	std::atomic<uint64_t> m_hitCount;
+	std::atomic<uint64_t> m_missCount;
+
+}; // class DecentTlsSessCache
+
+
+} // namespace Trusted
+} // namespace DecentEnclave
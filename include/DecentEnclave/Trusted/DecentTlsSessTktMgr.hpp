@@ -0,0 +1,277 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <mbedtls/ssl.h>
+#include <mbedTLScpp/SKey.hpp>
+#include <mbedTLScpp/TlsConfig.hpp>
+
+#include "../Common/Platform/AesGcm.hpp"
+#include "../Common/Platform/Random.hpp"
+#include "../Common/Time.hpp"
+#include "SKeyring.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Trusted
+{
+
+
+/**
+ * \brief TLS session ticket manager for the servers of Decent lambda calls.
+ *        The session state is sealed with AES-GCM, under a key taken from
+ *        the SKeyring, so tickets stay valid across connections (and
+ *        across instances sharing the same SKeyring key).
+ *
+ *        Ticket layout:
+ *        issue time (8) || IV (12) || state size (2) || state || tag (16);
+ *        everything before the state is authenticated as additional data.
+ */
+class DecentTlsSessTktMgr :
+	public mbedTLScpp::TlsSessTktMgrIntf
+{
+public: // static members:
+
+	using Base = mbedTLScpp::TlsSessTktMgrIntf;
+
+	static constexpr size_t sk_keyBitSize = 128;
+
+	using KeyType = mbedTLScpp::SKey<sk_keyBitSize>;
+	using CryptorType = Common::Platform::AesGcmSessionNative<sk_keyBitSize>;
+
+	static constexpr size_t sk_timeSize = sizeof(uint64_t);
+	static constexpr size_t sk_ivSize = 12;
+	static constexpr size_t sk_lenSize = sizeof(uint16_t);
+	static constexpr size_t sk_headerSize =
+		sk_timeSize + sk_ivSize + sk_lenSize;
+	static constexpr size_t sk_tagSize = 16;
+
+	/**
+	 * \brief Default lifetime of a ticket, in seconds.
+	 */
+	static constexpr uint32_t sk_defaultLifetime = 24 * 60 * 60;
+
+
+	/**
+	 * \brief Creates a ticket manager with the key named `skeyName` in the
+	 *        (locked) SKeyring; that key must have been registered with at
+	 *        least `sk_keyBitSize` bits.
+	 */
+	static std::shared_ptr<DecentTlsSessTktMgr> FromSKeyring(
+		const std::string& skeyName,
+		uint32_t lifetime = sk_defaultLifetime
+	)
+	{
+		return std::make_shared<DecentTlsSessTktMgr>(
+			SKeyring::GetInstance().GetSKey<sk_keyBitSize>(skeyName),
+			lifetime
+		);
+	}
+
+public:
+
+	DecentTlsSessTktMgr(
+		const KeyType& key,
+		uint32_t lifetime = sk_defaultLifetime
+	) :
+		Base(),
+		m_cryptorMutex(),
+		m_cryptor(key),
+		m_rand(),
+		m_lifetime(lifetime),
+		m_issuedCount(0),
+		m_acceptedCount(0),
+		m_rejectedCount(0)
+	{}
+
+	// LCOV_EXCL_START
+	virtual ~DecentTlsSessTktMgr() = default;
+	// LCOV_EXCL_STOP
+
+	virtual int Write(
+		const mbedtls_ssl_session* session,
+		unsigned char* start,
+		const unsigned char* end,
+		size_t* tlen,
+		uint32_t* lifetime
+	) override
+	{
+		*tlen = 0;
+
+		const size_t bufSize = static_cast<size_t>(end - start);
+		if (bufSize < (sk_headerSize + sk_tagSize))
+		{
+			return MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL;
+		}
+
+		unsigned char* state = start + sk_headerSize;
+		const size_t maxStateSize = std::min<size_t>(
+			bufSize - sk_headerSize - sk_tagSize,
+			UINT16_MAX
+		);
+		size_t stateSize = 0;
+		int ret = mbedtls_ssl_session_save(
+			session,
+			state,
+			maxStateSize,
+			&stateSize
+		);
+		if (ret != 0)
+		{
+			return ret;
+		}
+
+		try
+		{
+			WriteUInt(start, Common::UntrustedTime::Timestamp());
+			WriteUInt(
+				start + sk_timeSize + sk_ivSize,
+				static_cast<uint16_t>(stateSize)
+			);
+
+			std::lock_guard<std::mutex> lock(m_cryptorMutex);
+
+			m_rand.Rand(start + sk_timeSize, sk_ivSize);
+			auto tag = m_cryptor.EncryptInPlace(
+				start + sk_timeSize, sk_ivSize,
+				start, sk_headerSize,
+				state, stateSize
+			);
+			std::memcpy(state + stateSize, tag.data(), sk_tagSize);
+		}
+		catch (const std::exception&)
+		{
+			return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+		}
+
+		*tlen = sk_headerSize + stateSize + sk_tagSize;
+		*lifetime = m_lifetime;
+		++m_issuedCount;
+
+		return 0;
+	}
+
+	virtual int Parse(
+		mbedtls_ssl_session* session,
+		unsigned char* buf,
+		size_t len
+	) override
+	{
+		if (len < (sk_headerSize + sk_tagSize))
+		{
+			++m_rejectedCount;
+			return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+		}
+
+		const size_t stateSize = ReadUInt<uint16_t>(
+			buf + sk_timeSize + sk_ivSize
+		);
+		if (len != (sk_headerSize + stateSize + sk_tagSize))
+		{
+			++m_rejectedCount;
+			return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+		}
+
+		unsigned char* state = buf + sk_headerSize;
+		try
+		{
+			std::lock_guard<std::mutex> lock(m_cryptorMutex);
+
+			m_cryptor.DecryptInPlace(
+				buf + sk_timeSize, sk_ivSize,
+				buf, sk_headerSize,
+				state, stateSize,
+				state + stateSize
+			);
+		}
+		catch (const std::exception&)
+		{
+			++m_rejectedCount;
+			return MBEDTLS_ERR_SSL_INVALID_MAC;
+		}
+
+		const uint64_t issuedAt = ReadUInt<uint64_t>(buf);
+		const uint64_t now = Common::UntrustedTime::Timestamp();
+		if ((now < issuedAt) || ((now - issuedAt) > m_lifetime))
+		{
+			++m_rejectedCount;
+			return MBEDTLS_ERR_SSL_SESSION_TICKET_EXPIRED;
+		}
+
+		int ret = mbedtls_ssl_session_load(session, state, stateSize);
+		if (ret != 0)
+		{
+			++m_rejectedCount;
+			return ret;
+		}
+
+		++m_acceptedCount;
+		return 0;
+	}
+
+	uint64_t GetIssuedCount() const
+	{
+		return m_issuedCount.load();
+	}
+
+	uint64_t GetAcceptedCount() const
+	{
+		return m_acceptedCount.load();
+	}
+
+	uint64_t GetRejectedCount() const
+	{
+		return m_rejectedCount.load();
+	}
+
+private:
+
+	template<typename _UIntType>
+	static void WriteUInt(unsigned char* dest, _UIntType val)
+	{
+		for (size_t i = 0; i < sizeof(_UIntType); ++i)
+		{
+			dest[i] = static_cast<unsigned char>(val >> (i * 8));
+		}
+	}
+
+	template<typename _UIntType>
+	static _UIntType ReadUInt(const unsigned char* src)
+	{
+		_UIntType val = 0;
+		for (size_t i = 0; i < sizeof(_UIntType); ++i)
+		{
+			val |= static_cast<_UIntType>(src[i]) << (i * 8);
+		}
+		return val;
+	}
+
+	std::mutex m_cryptorMutex;
+	CryptorType m_cryptor;
+	Common::Platform::RandGenerator m_rand;
+	uint32_t m_lifetime;
+
+	std::atomic<uint64_t> m_issuedCount;
+	std::atomic<uint64_t> m_acceptedCount;
+	std::atomic<uint64_t> m_rejectedCount;
+
+}; // class DecentTlsSessTktMgr
+
+
+} // namespace Trusted
+} // namespace DecentEnclave
@@ -0,0 +1,463 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "../Common/Exceptions.hpp"
+#include "../Common/Time.hpp"
+#include "../Common/TlsSocket.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Trusted
+{
+
+
+struct LambdaConnPoolConfig
+{
+	using HealthCheckFunc = std::function<bool(Common::TlsSocket&)>;
+
+	LambdaConnPoolConfig() :
+		m_maxIdlePerPeer(4),
+		m_maxPerPeer(16),
+		m_maxIdleTime(30),
+		m_healthCheck()
+	{}
+
+	/**
+	 * \brief Max number of idle connections kept per peer; 0 disables the
+	 *        pooling (every connection is closed once returned).
+	 */
+	size_t m_maxIdlePerPeer;
+
+	/**
+	 * \brief Max number of connections (idle and checked out) per peer;
+	 *        checking out more blocks until one is returned.
+	 */
+	size_t m_maxPerPeer;
+
+	/**
+	 * \brief Idle connections older than this (in seconds) are closed
+	 *        instead of being checked out; it should be shorter than the
+	 *        peer's idle timeout (60 seconds by default), so connections are
+	 *        dropped here before the peer closes them.
+	 */
+	uint64_t m_maxIdleTime;
+
+	/**
+	 * \brief Optional check run on an idle connection before it's checked
+	 *        out; the connection is closed if it returns false.
+	 *        None is set by default, since a connection closed by the peer
+	 *        can't be detected without blocking; see `MakePooledLambdaCall`
+	 *        for how such connections are handled.
+	 */
+	HealthCheckFunc m_healthCheck;
+}; // struct LambdaConnPoolConfig
+
+
+class LambdaConnPool;
+
+
+/**
+ * \brief A connection checked out from `LambdaConnPool`. It's returned to
+ *        the pool when destroyed, unless it has been invalidated, or it's
+ *        destroyed because of an exception (the stream may then be in the
+ *        middle of a message).
+ */
+class LambdaConnHandle
+{
+public: // static members:
+
+	using SocketPtrType = std::unique_ptr<Common::TlsSocket>;
+
+public:
+
+	LambdaConnHandle(
+		LambdaConnPool& pool,
+		std::string componentName,
+		SocketPtrType socket
+	) :
+		m_pool(&pool),
+		m_componentName(std::move(componentName)),
+		m_socket(std::move(socket)),
+		m_isReusable(true)
+	{}
+
+	LambdaConnHandle(const LambdaConnHandle&) = delete;
+
+	LambdaConnHandle(LambdaConnHandle&& other) :
+		m_pool(other.m_pool),
+		m_componentName(std::move(other.m_componentName)),
+		m_socket(std::move(other.m_socket)),
+		m_isReusable(other.m_isReusable)
+	{
+		other.m_pool = nullptr;
+	}
+
+	~LambdaConnHandle()
+	{
+		Release();
+	}
+
+	LambdaConnHandle& operator=(const LambdaConnHandle&) = delete;
+
+	Common::TlsSocket& operator*() const
+	{
+		return *m_socket;
+	}
+
+	Common::TlsSocket* operator->() const
+	{
+		return m_socket.get();
+	}
+
+	Common::TlsSocket& Get() const
+	{
+		return *m_socket;
+	}
+
+	/**
+	 * \brief Mark the connection as not reusable, so it will be closed
+	 *        instead of being returned to the pool.
+	 */
+	void Invalidate()
+	{
+		m_isReusable = false;
+	}
+
+	/**
+	 * \brief Return the connection to the pool (or close it) now.
+	 */
+	void Release();
+
+private:
+
+	LambdaConnPool* m_pool;
+	std::string m_componentName;
+	SocketPtrType m_socket;
+	bool m_isReusable;
+
+}; // class LambdaConnHandle
+
+
+/**
+ * \brief Pool of idle TLS connections to other components, used by
+ *        `MakePooledLambdaCall`. The peer must keep serving requests on
+ *        the same connection (keep-alive mode of the lambda server).
+ */
+class LambdaConnPool
+{
+public: // static members:
+
+	using SocketPtrType = LambdaConnHandle::SocketPtrType;
+	using ConnectFunc = std::function<SocketPtrType()>;
+	using HealthCheckFunc = LambdaConnPoolConfig::HealthCheckFunc;
+
+	static LambdaConnPool& GetInstance()
+	{
+		static LambdaConnPool s_inst;
+		return s_inst;
+	}
+
+public:
+
+	LambdaConnPool() :
+		m_mutex(),
+		m_cond(),
+		m_config(),
+		m_peers(),
+		m_createdCount(0),
+		m_reusedCount(0),
+		m_discardedCount(0)
+	{}
+
+	~LambdaConnPool() = default;
+
+	void SetConfig(const LambdaConnPoolConfig& config)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_config = config;
+		if (m_config.m_maxPerPeer == 0)
+		{
+			m_config.m_maxPerPeer = 1;
+		}
+		m_cond.notify_all();
+	}
+
+	LambdaConnPoolConfig GetConfig() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_config;
+	}
+
+	/**
+	 * \brief Check out a connection to the given component; an idle one is
+	 *        reused if it passes the health checks, otherwise a new one is
+	 *        made by `connect`.
+	 *
+	 * \param isReused Set to whether an idle connection was reused.
+	 */
+	LambdaConnHandle CheckOut(
+		const std::string& componentName,
+		const ConnectFunc& connect,
+		bool* isReused = nullptr
+	)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		PeerConns& peer = m_peers[componentName];
+		while (true)
+		{
+			m_cond.wait(
+				lock,
+				[&]()
+				{
+					return !peer.m_idle.empty() ||
+						(peer.m_total < m_config.m_maxPerPeer);
+				}
+			);
+
+			if (peer.m_idle.empty())
+			{
+				break;
+			}
+
+			IdleConn conn = std::move(peer.m_idle.back());
+			peer.m_idle.pop_back();
+
+			bool isHealthy = AfterLockIsFresh(conn);
+			if (isHealthy && m_config.m_healthCheck)
+			{
+				// the check may talk to the peer, so it's run outside of the
+				// lock; the connection is still counted in the peer's total
+				const HealthCheckFunc healthCheck = m_config.m_healthCheck;
+				lock.unlock();
+				isHealthy = RunHealthCheck(healthCheck, *conn.m_socket);
+				lock.lock();
+			}
+
+			if (isHealthy)
+			{
+				++m_reusedCount;
+				if (isReused != nullptr)
+				{
+					*isReused = true;
+				}
+				return LambdaConnHandle(
+					*this,
+					componentName,
+					std::move(conn.m_socket)
+				);
+			}
+
+			// close it outside of the lock
+			--peer.m_total;
+			++m_discardedCount;
+			lock.unlock();
+			conn.m_socket.reset();
+			lock.lock();
+		}
+
+		// no usable idle connection; make a new one, outside of the lock
+		++peer.m_total;
+		lock.unlock();
+
+		SocketPtrType socket;
+		try
+		{
+			socket = connect();
+		}
+		catch (...)
+		{
+			OnConnClosed(componentName);
+			throw;
+		}
+
+		lock.lock();
+		++m_createdCount;
+		if (isReused != nullptr)
+		{
+			*isReused = false;
+		}
+		return LambdaConnHandle(*this, componentName, std::move(socket));
+	}
+
+	/**
+	 * \brief Return a checked-out connection; it's closed instead if it's
+	 *        not reusable, or if there are already enough idle connections
+	 *        to that component.
+	 */
+	void Return(
+		const std::string& componentName,
+		SocketPtrType socket,
+		bool isReusable
+	)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			PeerConns& peer = m_peers[componentName];
+			if (
+				isReusable &&
+				(socket != nullptr) &&
+				(peer.m_idle.size() < m_config.m_maxIdlePerPeer)
+			)
+			{
+				peer.m_idle.emplace_back(
+					IdleConn{
+						std::move(socket),
+						Common::UntrustedTime::Timestamp()
+					}
+				);
+				m_cond.notify_all();
+				return;
+			}
+		}
+
+		// close it outside of the lock
+		socket.reset();
+		OnConnClosed(componentName);
+	}
+
+	/**
+	 * \brief Close all idle connections.
+	 */
+	void Clear()
+	{
+		std::unordered_map<std::string, std::deque<IdleConn> > toClose;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto& peer : m_peers)
+			{
+				peer.second.m_total -= peer.second.m_idle.size();
+				m_discardedCount += peer.second.m_idle.size();
+				toClose[peer.first].swap(peer.second.m_idle);
+			}
+			m_cond.notify_all();
+		}
+	}
+
+	uint64_t GetCreatedCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_createdCount;
+	}
+
+	uint64_t GetReusedCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_reusedCount;
+	}
+
+	uint64_t GetDiscardedCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_discardedCount;
+	}
+
+private: // static members:
+
+	static bool RunHealthCheck(
+		const HealthCheckFunc& healthCheck,
+		Common::TlsSocket& socket
+	)
+	{
+		try
+		{
+			return healthCheck(socket);
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+private:
+
+	struct IdleConn
+	{
+		SocketPtrType m_socket;
+		uint64_t m_idleSince;
+	}; // struct IdleConn
+
+	struct PeerConns
+	{
+		PeerConns() :
+			m_idle(),
+			m_total(0)
+		{}
+
+		std::deque<IdleConn> m_idle;
+		size_t m_total;
+	}; // struct PeerConns
+
+	bool AfterLockIsFresh(const IdleConn& conn) const
+	{
+		const uint64_t now = Common::UntrustedTime::Timestamp();
+		return (now >= conn.m_idleSince) &&
+			((now - conn.m_idleSince) <= m_config.m_maxIdleTime);
+	}
+
+	void OnConnClosed(const std::string& componentName)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		PeerConns& peer = m_peers[componentName];
+		--peer.m_total;
+		++m_discardedCount;
+		m_cond.notify_all();
+	}
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cond;
+	LambdaConnPoolConfig m_config;
+	std::unordered_map<std::string, PeerConns> m_peers;
+
+	uint64_t m_createdCount;
+	uint64_t m_reusedCount;
+	uint64_t m_discardedCount;
+
+}; // class LambdaConnPool
+
+
+inline void LambdaConnHandle::Release()
+{
+	if (m_pool == nullptr)
+	{
+		return;
+	}
+
+	LambdaConnPool* pool = m_pool;
+	m_pool = nullptr;
+
+	// don't reuse a connection abandoned by an exception, since it may be
+	// in the middle of a message
+#if __cplusplus >= 201703L
+	const bool isUnwinding = (std::uncaught_exceptions() > 0);
+#else
+	const bool isUnwinding = std::uncaught_exception();
+#endif
+	const bool isReusable = m_isReusable && !isUnwinding;
+	pool->Return(m_componentName, std::move(m_socket), isReusable);
+}
+
+
+} // namespace Trusted
+} // namespace DecentEnclave
@@ -8,12 +8,17 @@
 
 // #ifdef DECENT_ENCLAVE_PLATFORM_SGX_TRUSTED
 
+#include <cstdint>
+#include <cstring>
+
 #include <memory>
 #include <string>
 
 #include <SimpleObjects/Internal/make_unique.hpp>
 #include <SimpleSysIO/StreamSocketBase.hpp>
 
+#include "../../Common/AsyncSocket.hpp"
+#include "../../Common/Exceptions.hpp"
 #include "../../Common/Internal/SimpleObj.hpp"
 #include "../../Common/Internal/SimpleSysIO.hpp"
 #include "../../Common/Sgx/Exceptions.hpp"
@@ -45,21 +50,45 @@ inline SSocketAsyncCallbackHandler& GetSSocketAsyncCallbackHandler()
 }
 
 
-class StreamSocket : public Common::Internal::SysIO::StreamSocketBase
+using SSocketAsyncSendCallbackType =
+	Common::AsyncSendSocketIntf::AsyncSendCallback;
+
+using SSocketAsyncSendCallbackHandler =
+	Trusted::UntrustedAsyncEventHandler<SSocketAsyncSendCallbackType>;
+
+
+inline SSocketAsyncSendCallbackHandler& GetSSocketAsyncSendCallbackHandler()
+{
+	static SSocketAsyncSendCallbackHandler s_handler;
+	return s_handler;
+}
+
+
+class StreamSocket :
+	public Common::Internal::SysIO::StreamSocketBase,
+	public Common::AsyncSendSocketIntf
 {
 public: // static members:
 
 	using Base = Common::Internal::SysIO::StreamSocketBase;
+	using AsyncSendBase = Common::AsyncSendSocketIntf;
 
 public:
 
 	StreamSocket(Base* ptr) :
-		m_ptr(ptr)
+		m_ptr(ptr),
+		m_asyncSend(MakeAsyncSendQueue(ptr)),
+		m_recvTimeout(0),
+		m_nextRecvTimeout(0),
+		m_isRecvTimedOut(false)
 	{}
 
 	// LCOV_EXCL_START
 	virtual ~StreamSocket()
 	{
+		// the untrusted side keeps the socket alive
+		// until the send in progress (if any) is done
+		m_asyncSend->Close();
 		ocall_decent_ssocket_disconnect(m_ptr);
 	}
 	// LCOV_EXCL_STOP
@@ -79,18 +108,79 @@ public:
 
 	virtual size_t RecvRaw(void* data, size_t size) override
 	{
+		const uint64_t timeout =
+			(m_nextRecvTimeout != 0) ? m_nextRecvTimeout : m_recvTimeout;
+		m_nextRecvTimeout = 0;
+
 		UntrustedBuffer<uint8_t> ub;
-		DECENTENCLAVE_SGX_OCALL_CHECK_ERROR_E_R(
-			ocall_decent_ssocket_recv_raw,
-			m_ptr,
-			size,
-			&(ub.m_data),
-			&(ub.m_size)
-		);
+		if (timeout == 0)
+		{
+			DECENTENCLAVE_SGX_OCALL_CHECK_ERROR_E_R(
+				ocall_decent_ssocket_recv_raw,
+				m_ptr,
+				size,
+				&(ub.m_data),
+				&(ub.m_size)
+			);
+		}
+		else
+		{
+			uint8_t isTimedOut = 0;
+			DECENTENCLAVE_SGX_OCALL_CHECK_ERROR_E_R(
+				ocall_decent_ssocket_recv_raw_timeout,
+				m_ptr,
+				size,
+				timeout,
+				&(ub.m_data),
+				&(ub.m_size),
+				&isTimedOut
+			);
+			if (isTimedOut)
+			{
+				m_isRecvTimedOut = true;
+				throw Common::TimeoutException(
+					"StreamSocket::RecvRaw - No data received in time"
+				);
+			}
+		}
 		std::memcpy(data, ub.m_data, ub.m_size);
 		return ub.m_size;
 	}
 
+	/**
+	 * \brief Set how long (in milliseconds) a receive waits for data
+	 *        before `Common::TimeoutException` is thrown; 0 (the default)
+	 *        waits forever.
+	 *        The socket can't be used any more after a timeout, since the
+	 *        receive is still pending on the untrusted side.
+	 */
+	void SetRecvTimeout(uint64_t timeout)
+	{
+		m_recvTimeout = timeout;
+	}
+
+	/**
+	 * \brief Same as `SetRecvTimeout`, but only for the next receive, e.g.,
+	 *        while waiting for the next request on an idle connection; the
+	 *        later receives wait as set by `SetRecvTimeout`. 0 clears it,
+	 *        e.g., if the next request was already buffered by the layers
+	 *        above, so no receive has been made.
+	 */
+	void SetNextRecvTimeout(uint64_t timeout)
+	{
+		m_nextRecvTimeout = timeout;
+	}
+
+	/**
+	 * \brief Whether a receive has timed out; it's also useful when the
+	 *        exception has been turned into an error code by the layers
+	 *        above (e.g., TLS).
+	 */
+	bool IsRecvTimedOut() const
+	{
+		return m_isRecvTimedOut;
+	}
+
 	virtual void AsyncRecvRaw(
 		size_t buffSize,
 		AsyncRecvCallback callback
@@ -107,9 +197,63 @@ public:
 		);
 	}
 
+	/**
+	 * \brief The data is copied out of the enclave, and sent by the
+	 *        untrusted side, so the calling thread is not held in the OCALL
+	 *        until the peer accepts it; the completion is delivered via
+	 *        `GetSSocketAsyncSendCallbackHandler`.
+	 */
+	virtual void AsyncSendRaw(
+		std::vector<uint8_t> data,
+		typename AsyncSendBase::AsyncSendCallback callback
+	) override
+	{
+		m_asyncSend->Push(std::move(data), std::move(callback));
+	}
+
 private:
 
+	static std::shared_ptr<Common::Internal::AsyncSendQueue>
+	MakeAsyncSendQueue(Base* ptr)
+	{
+		return std::make_shared<Common::Internal::AsyncSendQueue>(
+			[ptr](
+				std::vector<uint8_t> data,
+				Common::Internal::AsyncSendQueue::Callback callback
+			)
+			{
+				auto& handler = GetSSocketAsyncSendCallbackHandler();
+				auto regId = handler.RegisterCallback(std::move(callback));
+				try
+				{
+					DECENTENCLAVE_SGX_OCALL_CHECK_ERROR_E_R(
+						ocall_decent_ssocket_async_send_raw,
+						ptr,
+						data.data(),
+						data.size(),
+						SelfEnclaveId::Get(),
+						regId
+					);
+				}
+				catch (...)
+				{
+					// the send is not queued by the untrusted side
+					try
+					{
+						handler.DispatchCallback(regId, true, true);
+					}
+					catch (...)
+					{}
+				}
+			}
+		);
+	}
+
 	Base* m_ptr;
+	std::shared_ptr<Common::Internal::AsyncSendQueue> m_asyncSend;
+	uint64_t m_recvTimeout;
+	uint64_t m_nextRecvTimeout;
+	bool m_isRecvTimedOut;
 }; // class StreamSocket
 
 
@@ -19,6 +19,7 @@
 #include "../../Common/Internal/SimpleObj.hpp"
 #include "../../Common/Internal/SimpleSysIO.hpp"
 #include "../../Common/Exceptions.hpp"
+#include "../Hosting/BoostAsioServicePool.hpp"
 
 
 namespace DecentEnclave
@@ -50,15 +51,24 @@ public:
 
 class EndpointIP : public Endpoint
 {
+public: // static members:
+
+	using IoServicePoolType = Hosting::BoostAsioServicePool;
+
 public:
+	/**
+	 * \param ioPool Each new acceptor or socket is assigned to one of the
+	 *        io_services of this pool; the accepted sockets stay on their
+	 *        acceptor's.
+	 */
 	EndpointIP(
 		const std::string& ip,
 		const uint16_t port,
-		std::shared_ptr<boost::asio::io_service> ioService
+		std::shared_ptr<IoServicePoolType> ioPool
 	) :
 		m_ip(ip),
 		m_port(port),
-		m_ioService(std::move(ioService))
+		m_ioPool(std::move(ioPool))
 	{}
 
 	virtual
@@ -66,7 +76,11 @@ public:
 	GetStreamAcceptor() const override
 	{
 		using namespace Common::Internal::SysIO;
-		return SysCall::TCPAcceptor::BindV4(m_ip, m_port, m_ioService);
+		return SysCall::TCPAcceptor::BindV4(
+			m_ip,
+			m_port,
+			m_ioPool->AssignAcceptor()
+		);
 	}
 
 	virtual
@@ -74,7 +88,7 @@ public:
 	GetStreamSocket() const override
 	{
 		using namespace Common::Internal::SysIO;
-		return SysCall::TCPSocket::ConnectV4(m_ip, m_port, m_ioService);
+		return SysCall::TCPSocket::ConnectV4(m_ip, m_port, m_ioPool->Assign());
 	}
 
 private:
@@ -82,7 +96,7 @@ private:
 	std::string m_ip;
 	uint16_t m_port;
 
-	std::shared_ptr<boost::asio::io_service> m_ioService;
+	std::shared_ptr<IoServicePoolType> m_ioPool;
 
 }; // struct EndpointIP
 
@@ -100,15 +114,26 @@ public: // static members:
 		std::unordered_map<std::string, std::unique_ptr<Endpoint> >;
 	using EndpointsMap =
 		std::unordered_map<std::string, EndpointList>;
+	using IoServicePoolType = Hosting::BoostAsioServicePool;
 
 
+	/**
+	 * \param ioPool If it's given, the endpoints use it instead of
+	 *        `ioService`.
+	 */
 	static std::shared_ptr<EndpointsMgr> GetInstancePtr(
 		const Common::Internal::Obj::Object* config = nullptr,
-		std::shared_ptr<boost::asio::io_service> ioService = nullptr
+		std::shared_ptr<boost::asio::io_service> ioService = nullptr,
+		std::shared_ptr<IoServicePoolType> ioPool = nullptr
 	)
 	{
 		static std::shared_ptr<EndpointsMgr> s_instPtr =
-			std::make_shared<EndpointsMgr>(*config, ioService);
+			std::make_shared<EndpointsMgr>(
+				*config,
+				ioPool != nullptr ?
+					std::move(ioPool) :
+					std::make_shared<IoServicePoolType>(std::move(ioService))
+			);
 
 		return s_instPtr;
 	}
@@ -125,10 +150,21 @@ public:
 	EndpointsMgr(
 		const Common::Internal::Obj::Object& config,
 		std::shared_ptr<boost::asio::io_service> ioService
+	) :
+		EndpointsMgr(
+			config,
+			std::make_shared<IoServicePoolType>(std::move(ioService))
+		)
+	{}
+
+
+	EndpointsMgr(
+		const Common::Internal::Obj::Object& config,
+		std::shared_ptr<IoServicePoolType> ioPool
 	) :
 		m_inEndpoints(),
 		m_outEndpoints(),
-		m_ioService(std::move(ioService))
+		m_ioPool(std::move(ioPool))
 	{
 		using namespace Common::Internal::Obj;
 
@@ -160,7 +196,7 @@ public:
 						Internal::make_unique<EndpointIP>(
 							std::string(ip.c_str(), ip.size()),
 							static_cast<uint16_t>(port),
-							m_ioService
+							m_ioPool
 						)
 					);
 				}
@@ -171,7 +207,7 @@ public:
 						Internal::make_unique<EndpointIP>(
 							std::string(ip.c_str(), ip.size()),
 							static_cast<uint16_t>(port),
-							m_ioService
+							m_ioPool
 						)
 					);
 				}
@@ -200,6 +236,24 @@ public:
 	}
 
 
+	/**
+	 * \brief The first io_service used by the endpoints.
+	 */
+	std::shared_ptr<boost::asio::io_service> GetIoService() const
+	{
+		return m_ioPool->GetIoService(0);
+	}
+
+
+	/**
+	 * \brief The io_services used by the endpoints.
+	 */
+	std::shared_ptr<IoServicePoolType> GetIoServicePool() const
+	{
+		return m_ioPool;
+	}
+
+
 private: // static members:
 
 	static const Endpoint& PickAnyEndpointWithName(
@@ -227,7 +281,7 @@ private:
 	EndpointsMap m_inEndpoints;
 	EndpointsMap m_outEndpoints;
 
-	std::shared_ptr<boost::asio::io_service> m_ioService;
+	std::shared_ptr<IoServicePoolType> m_ioPool;
 
 }; // class EndpointsMgr
 
@@ -0,0 +1,278 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Common/Exceptions.hpp"
+#include "../Common/Platform/Print.hpp"
+#include "DecentEnclaveBase.hpp"
+#include "Hosting/DecentLambdaFunc.hpp"
+#include "Hosting/HeartbeatEmitter.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Untrusted
+{
+
+
+struct DecentEnclaveReplicaStats
+{
+	size_t m_numOutstanding;
+	uint64_t m_numCalls;
+	uint64_t m_numCallFailures;
+	uint64_t m_numHeartbeats;
+	uint64_t m_numHeartbeatFailures;
+	size_t m_numConsecFailures;
+	bool m_isHealthy;
+}; // struct DecentEnclaveReplicaStats
+
+
+/**
+ * \brief Replicas of the same enclave behind one lambda function; each call
+ *        goes to the healthy replica with the fewest calls in progress
+ *        (ties taken in turns), and the heartbeats go to all of them.
+ *        A replica becomes unhealthy after `maxConsecFailures` failures in
+ *        a row, and healthy again once a heartbeat to it succeeds.
+ */
+class DecentEnclaveReplicaPool :
+	virtual public Hosting::DecentLambdaFunc,
+	virtual public Hosting::HeartbeatEmitter
+{
+public: // static members:
+
+	using LmdFuncBase = Hosting::DecentLambdaFunc;
+	using HeartbeatBase = Hosting::HeartbeatEmitter;
+	using ReplicaType = DecentEnclaveBase;
+
+	static constexpr size_t sk_defaultMaxConsecFailures = 3;
+
+	/**
+	 * \brief Make `numReplicas` enclaves of type `_EnclaveType`, all
+	 *        constructed with the same arguments (e.g., the same AuthList).
+	 */
+	template<typename _EnclaveType, typename... _Args>
+	static std::shared_ptr<DecentEnclaveReplicaPool> Make(
+		size_t numReplicas,
+		_Args&&... args
+	)
+	{
+		std::vector<std::shared_ptr<ReplicaType> > replicas;
+		for (size_t i = 0; i < numReplicas; ++i)
+		{
+			// every replica uses the arguments, so they're not forwarded
+			replicas.emplace_back(std::make_shared<_EnclaveType>(args...));
+		}
+		return std::make_shared<DecentEnclaveReplicaPool>(
+			std::move(replicas)
+		);
+	}
+
+public:
+
+	DecentEnclaveReplicaPool(
+		std::vector<std::shared_ptr<ReplicaType> > replicas,
+		size_t maxConsecFailures = sk_defaultMaxConsecFailures
+	) :
+		m_maxConsecFailures(maxConsecFailures),
+		m_mutex(),
+		m_replicas(),
+		m_nextIdx(0)
+	{
+		if (replicas.empty())
+		{
+			throw Common::Exception(
+				"DecentEnclaveReplicaPool - At least one replica is needed"
+			);
+		}
+		for (auto& replica : replicas)
+		{
+			m_replicas.emplace_back(std::move(replica));
+		}
+	}
+
+	// LCOV_EXCL_START
+	virtual ~DecentEnclaveReplicaPool() = default;
+	// LCOV_EXCL_STOP
+
+	virtual void HandleCall(std::unique_ptr<SocketType> sock) override
+	{
+		Replica& replica = PickReplica();
+
+		bool hasFailed = true;
+		try
+		{
+			replica.m_enclave->HandleCall(std::move(sock));
+			hasFailed = false;
+		}
+		catch (...)
+		{
+			OnCallDone(replica, hasFailed);
+			throw;
+		}
+		OnCallDone(replica, hasFailed);
+	}
+
+	/**
+	 * \brief Send a heartbeat to every replica; if any of them fails, an
+	 *        exception is thrown after all of them are tried.
+	 */
+	virtual void Heartbeat() override
+	{
+		size_t numFailures = 0;
+		for (Replica& replica : m_replicas)
+		{
+			bool hasFailed = false;
+			try
+			{
+				replica.m_enclave->Heartbeat();
+			}
+			catch (const std::exception& e)
+			{
+				hasFailed = true;
+				++numFailures;
+				Common::Platform::Print::StrErr(
+					"DecentEnclaveReplicaPool - Heartbeat failed: " +
+					std::string(e.what())
+				);
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++replica.m_stats.m_numHeartbeats;
+			if (hasFailed)
+			{
+				++replica.m_stats.m_numHeartbeatFailures;
+				AfterLockOnFailure(replica);
+			}
+			else
+			{
+				replica.m_stats.m_numConsecFailures = 0;
+				replica.m_stats.m_isHealthy = true;
+			}
+		}
+
+		if (numFailures > 0)
+		{
+			throw Common::Exception(
+				"DecentEnclaveReplicaPool - Heartbeat failed on " +
+				std::to_string(numFailures) + " replica(s)"
+			);
+		}
+	}
+
+	size_t GetNumReplicas() const
+	{
+		return m_replicas.size();
+	}
+
+	std::vector<DecentEnclaveReplicaStats> GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<DecentEnclaveReplicaStats> stats;
+		stats.reserve(m_replicas.size());
+		for (const Replica& replica : m_replicas)
+		{
+			stats.push_back(replica.m_stats);
+		}
+		return stats;
+	}
+
+private:
+
+	struct Replica
+	{
+		Replica(std::shared_ptr<ReplicaType> enclave) :
+			m_enclave(std::move(enclave)),
+			m_stats()
+		{
+			m_stats.m_isHealthy = true;
+		}
+
+		std::shared_ptr<ReplicaType> m_enclave;
+		DecentEnclaveReplicaStats m_stats;
+	}; // struct Replica
+
+	Replica& PickReplica()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// if none of them is healthy, still try the least busy one
+		const size_t numReplicas = m_replicas.size();
+		Replica* best = nullptr;
+		for (size_t i = 0; i < numReplicas; ++i)
+		{
+			Replica& replica = m_replicas[(m_nextIdx + i) % numReplicas];
+			if (best == nullptr)
+			{
+				best = &replica;
+				continue;
+			}
+
+			const DecentEnclaveReplicaStats& curr = replica.m_stats;
+			const DecentEnclaveReplicaStats& prev = best->m_stats;
+			if (
+				(curr.m_isHealthy && !prev.m_isHealthy) ||
+				(
+					(curr.m_isHealthy == prev.m_isHealthy) &&
+					(curr.m_numOutstanding < prev.m_numOutstanding)
+				)
+			)
+			{
+				best = &replica;
+			}
+		}
+
+		m_nextIdx = (m_nextIdx + 1) % numReplicas;
+		++best->m_stats.m_numOutstanding;
+		++best->m_stats.m_numCalls;
+		return *best;
+	}
+
+	void OnCallDone(Replica& replica, bool hasFailed)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--replica.m_stats.m_numOutstanding;
+		if (hasFailed)
+		{
+			++replica.m_stats.m_numCallFailures;
+			AfterLockOnFailure(replica);
+		}
+		else
+		{
+			replica.m_stats.m_numConsecFailures = 0;
+		}
+	}
+
+	void AfterLockOnFailure(Replica& replica)
+	{
+		++replica.m_stats.m_numConsecFailures;
+		if (replica.m_stats.m_numConsecFailures >= m_maxConsecFailures)
+		{
+			replica.m_stats.m_isHealthy = false;
+		}
+	}
+
+	size_t m_maxConsecFailures;
+
+	mutable std::mutex m_mutex;
+	// not resized after construction, so references to replicas stay valid
+	std::vector<Replica> m_replicas;
+	size_t m_nextIdx;
+
+}; // class DecentEnclaveReplicaPool
+
+
+} // namespace Untrusted
+} // namespace DecentEnclave
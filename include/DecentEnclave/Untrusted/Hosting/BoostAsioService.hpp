@@ -7,12 +7,19 @@
 
 
 #include <memory>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif // __linux__
 
 #include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/io_service.hpp>
 #include <SimpleConcurrency/Threading/Task.hpp>
 
 #include "../../Common/Internal/SimpleConcurrency.hpp"
+#include "../../Common/Platform/Print.hpp"
 
 
 namespace DecentEnclave
@@ -29,15 +36,23 @@ public: // static members:
 
 	using Base = Common::Internal::Concurrent::Threading::Task;
 
+	static constexpr int sk_noAffinity = -1;
+
 public:
 
+	/**
+	 * \param cpuCore The CPU core the thread running this service is pinned
+	 *        to, or `sk_noAffinity`; pinning is only supported on Linux.
+	 */
 	BoostAsioService(
 		std::shared_ptr<boost::asio::io_service> ioService =
-			std::make_shared<boost::asio::io_service>()
+			std::make_shared<boost::asio::io_service>(),
+		int cpuCore = sk_noAffinity
 	) :
 		Base(),
 		m_ioService(std::move(ioService)),
-		m_workGuard(boost::asio::make_work_guard(*m_ioService))
+		m_workGuard(boost::asio::make_work_guard(*m_ioService)),
+		m_cpuCore(cpuCore)
 	{}
 
 	// LCOV_EXCL_START
@@ -47,7 +62,8 @@ public:
 
 	BoostAsioService(BoostAsioService&& other) :
 		m_ioService(std::move(other.m_ioService)),
-		m_workGuard(std::move(other.m_workGuard))
+		m_workGuard(std::move(other.m_workGuard)),
+		m_cpuCore(other.m_cpuCore)
 	{}
 
 
@@ -64,6 +80,10 @@ public:
 
 	virtual void Run() override
 	{
+		if (m_cpuCore != sk_noAffinity)
+		{
+			PinCurrentThread(m_cpuCore);
+		}
 		m_ioService->run();
 	}
 
@@ -74,11 +94,41 @@ public:
 	}
 
 
+private: // static members:
+
+	static void PinCurrentThread(int cpuCore)
+	{
+#ifdef __linux__
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(cpuCore, &cpuSet);
+		int ret = pthread_setaffinity_np(
+			pthread_self(),
+			sizeof(cpuSet),
+			&cpuSet
+		);
+		if (ret != 0)
+		{
+			// the service still runs, just without the affinity
+			Common::Platform::Print::StrErr(
+				"BoostAsioService - Failed to pin the thread to core " +
+				std::to_string(cpuCore)
+			);
+		}
+#else // __linux__
+		(void)cpuCore;
+		Common::Platform::Print::StrErr(
+			"BoostAsioService - Thread pinning is not supported"
+		);
+#endif // __linux__
+	}
+
 private:
 
 	std::shared_ptr<boost::asio::io_service> m_ioService;
 	boost::asio::executor_work_guard<boost::asio::io_context::executor_type>
 		m_workGuard;
+	int m_cpuCore;
 
 }; // class BoostAsioService
 
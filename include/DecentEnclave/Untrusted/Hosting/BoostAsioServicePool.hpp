@@ -0,0 +1,367 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/post.hpp>
+#include <SimpleObjects/Internal/make_unique.hpp>
+
+#include "../../Common/Exceptions.hpp"
+#include "../../Common/Internal/SimpleObj.hpp"
+#include "BoostAsioService.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Untrusted
+{
+namespace Hosting
+{
+
+
+/**
+ * \brief A set of io_services (contexts), each run by one or more
+ *        `BoostAsioService` tasks, so the async socket completions are not
+ *        serialized through a single thread. New sockets are assigned to
+ *        the contexts in turns.
+ *        An accepted socket stays on the context of its acceptor, so the
+ *        acceptors can be given their own context, run by several threads,
+ *        to spread the completions of the inbound connections.
+ */
+class BoostAsioServicePool
+{
+public: // static members:
+
+	struct ContextStats
+	{
+		/**
+		 * \brief Number of handlers queued through `Post` that have not
+		 *        run yet; completions of the sockets' own async operations
+		 *        are not visible here.
+		 */
+		size_t m_queueDepth;
+		uint64_t m_numPosted;
+		/**
+		 * \brief Number of sockets (or acceptors) assigned to it so far.
+		 */
+		uint64_t m_numAssigned;
+	}; // struct ContextStats
+
+	/**
+	 * \brief One context per CPU core, run by one thread pinned to it, for
+	 *        the outbound sockets; and one context for the acceptors, run
+	 *        by as many (unpinned) threads, for the inbound ones.
+	 */
+	static std::shared_ptr<BoostAsioServicePool> MakePerCore()
+	{
+		const size_t numCores = GetNumCores();
+		return std::make_shared<BoostAsioServicePool>(
+			numCores,
+			1,
+			true,
+			numCores
+		);
+	}
+
+	static size_t GetNumCores()
+	{
+		size_t numCores = std::thread::hardware_concurrency();
+		return numCores == 0 ? 1 : numCores;
+	}
+
+public:
+
+	/**
+	 * \param threadsPerContext Number of `BoostAsioService` tasks made by
+	 *        `MakeServices` for each context.
+	 * \param pinToCores Whether the tasks of the i-th context are pinned to
+	 *        core i (modulo the number of cores).
+	 * \param acceptorThreads Number of threads running the context of the
+	 *        acceptors, and so of the inbound connections; 0 means the
+	 *        acceptors are assigned to the contexts like the other sockets.
+	 */
+	BoostAsioServicePool(
+		size_t numContexts,
+		size_t threadsPerContext = 1,
+		bool pinToCores = false,
+		size_t acceptorThreads = 0
+	) :
+		m_contexts(),
+		m_acceptorContext(),
+		m_threadsPerContext(threadsPerContext),
+		m_pinToCores(pinToCores),
+		m_acceptorThreads(acceptorThreads),
+		m_nextIdx(0)
+	{
+		if ((numContexts == 0) || (m_threadsPerContext == 0))
+		{
+			throw Common::Exception(
+				"BoostAsioServicePool - "
+				"At least one context and one thread are needed"
+			);
+		}
+
+		for (size_t i = 0; i < numContexts; ++i)
+		{
+			m_contexts.emplace_back(
+				std::make_shared<Context>(
+					std::make_shared<boost::asio::io_service>()
+				)
+			);
+		}
+
+		if (m_acceptorThreads > 0)
+		{
+			m_acceptorContext = std::make_shared<Context>(
+				std::make_shared<boost::asio::io_service>()
+			);
+		}
+	}
+
+	/**
+	 * \brief A pool of the given io_service only, which is run by the
+	 *        caller as before.
+	 */
+	explicit BoostAsioServicePool(
+		std::shared_ptr<boost::asio::io_service> ioService
+	) :
+		m_contexts(),
+		m_acceptorContext(),
+		m_threadsPerContext(1),
+		m_pinToCores(false),
+		m_acceptorThreads(0),
+		m_nextIdx(0)
+	{
+		m_contexts.emplace_back(
+			std::make_shared<Context>(std::move(ioService))
+		);
+	}
+
+	~BoostAsioServicePool() = default;
+
+	BoostAsioServicePool(const BoostAsioServicePool& other) = delete;
+	BoostAsioServicePool& operator=(const BoostAsioServicePool& other) = delete;
+
+	/**
+	 * \brief Make the tasks running the contexts, to be added to the
+	 *        thread pool (which must have enough threads for all of them).
+	 */
+	std::vector<std::unique_ptr<BoostAsioService> > MakeServices() const
+	{
+		std::vector<std::unique_ptr<BoostAsioService> > services;
+		const size_t numCores = GetNumCores();
+		for (size_t i = 0; i < m_contexts.size(); ++i)
+		{
+			const int cpuCore = m_pinToCores ?
+				static_cast<int>(i % numCores) :
+				BoostAsioService::sk_noAffinity;
+			for (size_t j = 0; j < m_threadsPerContext; ++j)
+			{
+				services.emplace_back(
+					Common::Internal::Obj::Internal::make_unique<
+						BoostAsioService
+					>(
+						m_contexts[i]->m_ioService,
+						cpuCore
+					)
+				);
+			}
+		}
+		// the acceptors' context is not pinned, as it's run by many threads
+		const int acceptorCpuCore = BoostAsioService::sk_noAffinity;
+		for (size_t j = 0; j < m_acceptorThreads; ++j)
+		{
+			services.emplace_back(
+				Common::Internal::Obj::Internal::make_unique<
+					BoostAsioService
+				>(
+					m_acceptorContext->m_ioService,
+					acceptorCpuCore
+				)
+			);
+		}
+		return services;
+	}
+
+	/**
+	 * \brief Number of contexts, not counting the one of the acceptors.
+	 */
+	size_t GetNumContexts() const
+	{
+		return m_contexts.size();
+	}
+
+	std::shared_ptr<boost::asio::io_service> GetIoService(size_t idx) const
+	{
+		return m_contexts.at(idx)->m_ioService;
+	}
+
+	/**
+	 * \brief Pick the context for a new socket.
+	 */
+	std::shared_ptr<boost::asio::io_service> Assign()
+	{
+		Context& ctx = *m_contexts[(m_nextIdx++) % m_contexts.size()];
+		++(ctx.m_numAssigned);
+		return ctx.m_ioService;
+	}
+
+	/**
+	 * \brief Pick the context for a new acceptor, which is also the one of
+	 *        the connections it accepts.
+	 */
+	std::shared_ptr<boost::asio::io_service> AssignAcceptor()
+	{
+		if (m_acceptorContext == nullptr)
+		{
+			return Assign();
+		}
+		++(m_acceptorContext->m_numAssigned);
+		return m_acceptorContext->m_ioService;
+	}
+
+	/**
+	 * \brief Run the handler on the given io_service of this pool, e.g.,
+	 *        the one of the socket it works on, so it's serialized with
+	 *        that socket's completions when the context has one thread;
+	 *        it's counted in the queue depth until it runs.
+	 */
+	void Post(
+		const boost::asio::io_service& ioService,
+		std::function<void()> handler
+	)
+	{
+		const std::shared_ptr<Context>& ctx = FindContext(ioService);
+		++(ctx->m_queueDepth);
+		++(ctx->m_numPosted);
+		try
+		{
+			// the handler may run after this pool is gone, but it must not
+			// own the context, which owns the io_service queuing it
+			std::weak_ptr<Context> weakCtx = ctx;
+			boost::asio::post(
+				*(ctx->m_ioService),
+				[weakCtx, handler]()
+				{
+					auto ctxPtr = weakCtx.lock();
+					if (ctxPtr != nullptr)
+					{
+						--(ctxPtr->m_queueDepth);
+					}
+					handler();
+				}
+			);
+		}
+		catch (...)
+		{
+			--(ctx->m_queueDepth);
+			throw;
+		}
+	}
+
+	/**
+	 * \return The stats of each context, in order, followed by those of the
+	 *         acceptors' context, if there is one.
+	 */
+	std::vector<ContextStats> GetStats() const
+	{
+		std::vector<ContextStats> stats;
+		stats.reserve(m_contexts.size() + 1);
+		for (const auto& ctx : m_contexts)
+		{
+			stats.push_back(ToStats(*ctx));
+		}
+		if (m_acceptorContext != nullptr)
+		{
+			stats.push_back(ToStats(*m_acceptorContext));
+		}
+		return stats;
+	}
+
+	void Stop()
+	{
+		for (const auto& ctx : m_contexts)
+		{
+			ctx->m_ioService->stop();
+		}
+		if (m_acceptorContext != nullptr)
+		{
+			m_acceptorContext->m_ioService->stop();
+		}
+	}
+
+private:
+
+	struct Context
+	{
+		Context(std::shared_ptr<boost::asio::io_service> ioService) :
+			m_ioService(std::move(ioService)),
+			m_queueDepth(0),
+			m_numPosted(0),
+			m_numAssigned(0)
+		{}
+
+		std::shared_ptr<boost::asio::io_service> m_ioService;
+		std::atomic<size_t> m_queueDepth;
+		std::atomic<uint64_t> m_numPosted;
+		std::atomic<uint64_t> m_numAssigned;
+	}; // struct Context
+
+	static ContextStats ToStats(const Context& ctx)
+	{
+		return ContextStats{
+			ctx.m_queueDepth.load(),
+			ctx.m_numPosted.load(),
+			ctx.m_numAssigned.load(),
+		};
+	}
+
+	const std::shared_ptr<Context>& FindContext(
+		const boost::asio::io_service& ioService
+	) const
+	{
+		for (const auto& ctx : m_contexts)
+		{
+			if (ctx->m_ioService.get() == &ioService)
+			{
+				return ctx;
+			}
+		}
+		if (
+			(m_acceptorContext != nullptr) &&
+			(m_acceptorContext->m_ioService.get() == &ioService)
+		)
+		{
+			return m_acceptorContext;
+		}
+		throw Common::Exception(
+			"BoostAsioServicePool - The io_service is not in this pool"
+		);
+	}
+
+	std::vector<std::shared_ptr<Context> > m_contexts;
+	std::shared_ptr<Context> m_acceptorContext;
+	size_t m_threadsPerContext;
+	bool m_pinToCores;
+	size_t m_acceptorThreads;
+	std::atomic<size_t> m_nextIdx;
+
+}; // class BoostAsioServicePool
+
+
+} // namespace Hosting
+} // namespace Untrusted
+} // namespace DecentEnclave
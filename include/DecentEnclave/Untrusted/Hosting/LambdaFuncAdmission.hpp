@@ -0,0 +1,365 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <SimpleConcurrency/Threading/Task.hpp>
+#include <SimpleObjects/Internal/make_unique.hpp>
+#include <SimpleSysIO/StreamSocketBase.hpp>
+
+#include "../../Common/Exceptions.hpp"
+#include "../../Common/Internal/SimpleConcurrency.hpp"
+#include "../../Common/Internal/SimpleObj.hpp"
+#include "../../Common/Internal/SimpleSysIO.hpp"
+#include "../../Common/Platform/Print.hpp"
+#include "DecentLambdaFunc.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Untrusted
+{
+namespace Hosting
+{
+
+
+struct LambdaFuncAdmissionConfig
+{
+	LambdaFuncAdmissionConfig() :
+		m_maxInFlight(std::numeric_limits<size_t>::max()),
+		m_maxQueued(std::numeric_limits<size_t>::max()),
+		m_maxQueueTime(0)
+	{}
+
+	LambdaFuncAdmissionConfig(
+		size_t maxInFlight,
+		size_t maxQueued,
+		std::chrono::milliseconds maxQueueTime = std::chrono::milliseconds(0)
+	) :
+		m_maxInFlight(maxInFlight),
+		m_maxQueued(maxQueued),
+		m_maxQueueTime(maxQueueTime)
+	{}
+
+	/**
+	 * \brief Max number of connections being handled at the same time; a
+	 *        keep-alive connection holds its slot across its calls, and
+	 *        while it's idle, until the enclave closes it (e.g., after
+	 *        its idle timeout), so this is not a bound on the calls.
+	 */
+	size_t m_maxInFlight;
+
+	/**
+	 * \brief Max number of connections waiting for a call slot; the ones
+	 *        beyond it are closed right away.
+	 */
+	size_t m_maxQueued;
+
+	/**
+	 * \brief Connections waiting longer than this are closed instead of
+	 *        being handled; 0 means no deadline.
+	 *        The deadlines are checked whenever a connection is admitted
+	 *        or a slot is freed, so a connection may be closed a bit later
+	 *        than its deadline while there is no activity.
+	 */
+	std::chrono::milliseconds m_maxQueueTime;
+}; // struct LambdaFuncAdmissionConfig
+
+
+struct LambdaFuncAdmissionStats
+{
+	uint64_t m_numAccepted;
+	uint64_t m_numQueued;
+	/**
+	 * \brief Closed because the queue was full.
+	 */
+	uint64_t m_numShed;
+	/**
+	 * \brief Closed because they waited longer than the deadline.
+	 */
+	uint64_t m_numExpired;
+	uint64_t m_numCompleted;
+	uint64_t m_numFailed;
+
+	uint64_t m_totalQueueTimeUs;
+	uint64_t m_maxQueueTimeUs;
+	uint64_t m_totalHandleTimeUs;
+	uint64_t m_maxHandleTimeUs;
+
+	size_t m_currInFlight;
+	size_t m_currQueued;
+}; // struct LambdaFuncAdmissionStats
+
+
+/**
+ * \brief Bounds the calls to a `DecentLambdaFunc`: up to `m_maxInFlight`
+ *        calls are handled at the same time, up to `m_maxQueued` more wait
+ *        for a slot, and the rest are shed by closing the connection,
+ *        before any TLS work is done for it.
+ *        The unit is a connection, since that's what the untrusted side
+ *        sees; with keep-alive, one connection carries many calls, and
+ *        holds its slot until it's closed.
+ *        A thread finishing a call goes on with the next waiting one, so
+ *        queued calls don't need to be re-dispatched.
+ */
+class LambdaFuncAdmission :
+	public std::enable_shared_from_this<LambdaFuncAdmission>
+{
+public: // static members:
+
+	using SocketType = Common::Internal::SysIO::StreamSocketBase;
+	using TaskType = Common::Internal::Concurrent::Threading::Task;
+	using ClockType = std::chrono::steady_clock;
+
+public:
+
+	LambdaFuncAdmission(
+		std::shared_ptr<DecentLambdaFunc> func,
+		LambdaFuncAdmissionConfig config = LambdaFuncAdmissionConfig()
+	) :
+		m_func(std::move(func)),
+		m_config(config),
+		m_mutex(),
+		m_queue(),
+		m_stats()
+	{
+		if (m_config.m_maxInFlight == 0)
+		{
+			throw Common::Exception(
+				"LambdaFuncAdmission - At least one call must be allowed"
+			);
+		}
+	}
+
+	~LambdaFuncAdmission() = default;
+
+	/**
+	 * \brief Admit a new connection.
+	 *
+	 * \return The task handling the call, if it can start now; otherwise
+	 *         `nullptr`, as the connection has been queued or closed.
+	 */
+	std::unique_ptr<TaskType> Admit(std::unique_ptr<SocketType> sock)
+	{
+		// expired connections are closed outside of the lock
+		std::deque<std::unique_ptr<SocketType> > expired;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_stats.m_numAccepted;
+
+			// the queue is in arrival order, so the expired ones are in front
+			const ClockType::time_point now = ClockType::now();
+			while (
+				!m_queue.empty() &&
+				AfterLockIsExpired(m_queue.front(), now)
+			)
+			{
+				++m_stats.m_numExpired;
+				expired.emplace_back(std::move(m_queue.front().m_sock));
+				m_queue.pop_front();
+			}
+			m_stats.m_currQueued = m_queue.size();
+
+			if (m_stats.m_currInFlight < m_config.m_maxInFlight)
+			{
+				++m_stats.m_currInFlight;
+				return Common::Internal::Obj::Internal::make_unique<CallTask>(
+					shared_from_this(),
+					std::move(sock)
+				);
+			}
+
+			if (m_queue.size() < m_config.m_maxQueued)
+			{
+				++m_stats.m_numQueued;
+				m_queue.emplace_back(QueuedCall{ std::move(sock), now });
+				m_stats.m_currQueued = m_queue.size();
+				return nullptr;
+			}
+
+			++m_stats.m_numShed;
+		}
+
+		// shed; the connection is closed outside of the lock
+		sock.reset();
+		return nullptr;
+	}
+
+	LambdaFuncAdmissionStats GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+	const LambdaFuncAdmissionConfig& GetConfig() const
+	{
+		return m_config;
+	}
+
+private:
+
+	struct QueuedCall
+	{
+		std::unique_ptr<SocketType> m_sock;
+		ClockType::time_point m_queuedTime;
+	}; // struct QueuedCall
+
+	class CallTask : public TaskType
+	{
+	public:
+
+		CallTask(
+			std::shared_ptr<LambdaFuncAdmission> admission,
+			std::unique_ptr<SocketType> sock
+		) :
+			TaskType(),
+			m_admission(std::move(admission)),
+			m_sock(std::move(sock))
+		{}
+
+		// LCOV_EXCL_START
+		virtual ~CallTask() = default;
+		// LCOV_EXCL_STOP
+
+		virtual void Run() override
+		{
+			std::unique_ptr<SocketType> sock = std::move(m_sock);
+			while (sock != nullptr)
+			{
+				m_admission->HandleCall(std::move(sock));
+				sock = m_admission->OnCallDone();
+			}
+		}
+
+		virtual void Terminate() override
+		{
+			// there's no general way to interrupt a call in progress
+		}
+
+	private:
+
+		std::shared_ptr<LambdaFuncAdmission> m_admission;
+		std::unique_ptr<SocketType> m_sock;
+
+	}; // class CallTask
+
+	static uint64_t ToUs(ClockType::duration d)
+	{
+		return static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::microseconds>(d).count()
+		);
+	}
+
+	void HandleCall(std::unique_ptr<SocketType> sock)
+	{
+		const ClockType::time_point start = ClockType::now();
+		bool hasFailed = false;
+		try
+		{
+			m_func->HandleCall(std::move(sock));
+		}
+		catch (const std::exception& e)
+		{
+			hasFailed = true;
+			Common::Platform::Print::StrErr(
+				"LambdaFuncAdmission - Failed to handle the call: " +
+				std::string(e.what())
+			);
+		}
+		const uint64_t handleTimeUs = ToUs(ClockType::now() - start);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (hasFailed)
+		{
+			++m_stats.m_numFailed;
+		}
+		else
+		{
+			++m_stats.m_numCompleted;
+		}
+		m_stats.m_totalHandleTimeUs += handleTimeUs;
+		if (handleTimeUs > m_stats.m_maxHandleTimeUs)
+		{
+			m_stats.m_maxHandleTimeUs = handleTimeUs;
+		}
+	}
+
+	/**
+	 * \return The next queued connection, which takes over the slot of the
+	 *         finished call; `nullptr` if there is none, and the slot is
+	 *         released.
+	 */
+	std::unique_ptr<SocketType> OnCallDone()
+	{
+		// expired connections are closed outside of the lock
+		std::deque<std::unique_ptr<SocketType> > expired;
+		std::unique_ptr<SocketType> next;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			const ClockType::time_point now = ClockType::now();
+			while ((next == nullptr) && !m_queue.empty())
+			{
+				QueuedCall call = std::move(m_queue.front());
+				m_queue.pop_front();
+
+				if (AfterLockIsExpired(call, now))
+				{
+					++m_stats.m_numExpired;
+					expired.emplace_back(std::move(call.m_sock));
+					continue;
+				}
+
+				const uint64_t queueTimeUs = ToUs(now - call.m_queuedTime);
+				m_stats.m_totalQueueTimeUs += queueTimeUs;
+				if (queueTimeUs > m_stats.m_maxQueueTimeUs)
+				{
+					m_stats.m_maxQueueTimeUs = queueTimeUs;
+				}
+				next = std::move(call.m_sock);
+			}
+			m_stats.m_currQueued = m_queue.size();
+
+			if (next == nullptr)
+			{
+				--m_stats.m_currInFlight;
+			}
+		}
+		return next;
+	}
+
+	bool AfterLockIsExpired(
+		const QueuedCall& call,
+		ClockType::time_point now
+	) const
+	{
+		return (m_config.m_maxQueueTime.count() > 0) &&
+			((now - call.m_queuedTime) > m_config.m_maxQueueTime);
+	}
+
+	std::shared_ptr<DecentLambdaFunc> m_func;
+	LambdaFuncAdmissionConfig m_config;
+
+	mutable std::mutex m_mutex;
+	std::deque<QueuedCall> m_queue;
+	LambdaFuncAdmissionStats m_stats;
+
+}; // class LambdaFuncAdmission
+
+
+} // namespace Hosting
+} // namespace Untrusted
+} // namespace DecentEnclave
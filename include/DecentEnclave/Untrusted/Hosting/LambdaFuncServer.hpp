@@ -6,21 +6,23 @@
 #pragma once
 
 
+#include <cstddef>
+
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 #include <SimpleConcurrency/Threading/ThreadPool.hpp>
-#include <SimpleObjects/Internal/make_unique.hpp>
 #include <SimpleSysIO/StreamSocketBase.hpp>
 
 #include "../../Common/Exceptions.hpp"
 #include "../../Common/Internal/SimpleConcurrency.hpp"
-#include "../../Common/Internal/SimpleObj.hpp"
 #include "../../Common/Internal/SimpleSysIO.hpp"
 #include "../../Common/Platform/Print.hpp"
 #include "../Config/EndpointsMgr.hpp"
 #include "DecentLambdaFunc.hpp"
-#include "LambdaFuncTask.hpp"
+#include "LambdaFuncAdmission.hpp"
 
 
 namespace DecentEnclave
@@ -39,29 +41,55 @@ public: // static members:
 	using AcceptorType = Common::Internal::SysIO::StreamAcceptorBase;
 	using ThreadPoolType = Common::Internal::Concurrent::Threading::ThreadPool;
 
-	using ServerBinding = std::pair<
-		std::shared_ptr<DecentLambdaFunc>,
-		std::shared_ptr<AcceptorType>
-	>;
+	using AdmissionType = LambdaFuncAdmission;
+	using AdmissionConfig = LambdaFuncAdmissionConfig;
+	using AdmissionStats = LambdaFuncAdmissionStats;
 
 public:
 
+	/**
+	 * \param numAcceptShards Number of accepts kept pending on the acceptor
+	 *        of each function; with the io_service run by as many threads
+	 *        (e.g., several `BoostAsioService` sharing it), a connection
+	 *        accepted while the others are being dispatched doesn't wait
+	 *        for the accept to be re-armed.
+	 */
 	LambdaFuncServer(
 		std::shared_ptr<Config::EndpointsMgr> endpointsMgr,
-		std::shared_ptr<ThreadPoolType> threadPool
+		std::shared_ptr<ThreadPoolType> threadPool,
+		size_t numAcceptShards = 1
 	) :
 		m_endpointsMgr(std::move(endpointsMgr)),
 		m_threadPool(std::move(threadPool)),
+		m_numAcceptShards(numAcceptShards),
 		m_funcMap()
-	{}
+	{
+		if (m_numAcceptShards == 0)
+		{
+			throw Common::Exception(
+				"LambdaFuncServer - At least one accept shard is needed"
+			);
+		}
+		if (m_threadPool == nullptr)
+		{
+			throw Common::Exception(
+				"LambdaFuncServer - A thread pool is needed to handle calls"
+			);
+		}
+	}
 
 
 	~LambdaFuncServer() = default;
 
 
+	/**
+	 * \param admissionConfig Bounds of the calls to this function; by
+	 *        default, every accepted connection is handled.
+	 */
 	void AddFunction(
 		const std::string& name,
-		std::shared_ptr<DecentLambdaFunc> func
+		std::shared_ptr<DecentLambdaFunc> func,
+		AdmissionConfig admissionConfig = AdmissionConfig()
 	)
 	{
 		if (m_funcMap.find(name) != m_funcMap.end())
@@ -69,44 +97,85 @@ public:
 			throw Common::Exception("Function name already exists.");
 		}
 
-		std::shared_ptr<AcceptorType> acceptor =
-			m_endpointsMgr->GetStreamAcceptor(name);
+		auto acceptor = std::make_shared<SharedAcceptor>(
+			m_endpointsMgr->GetStreamAcceptor(name)
+		);
+
+		auto admission =
+			std::make_shared<AdmissionType>(std::move(func), admissionConfig);
 
 		auto res = m_funcMap.emplace(
 			name,
-			std::make_pair(std::move(func), std::move(acceptor))
+			std::make_pair(std::move(admission), std::move(acceptor))
 		);
 
-		StartAccepting(
-			res.first->second.first,
-			res.first->second.second,
-			m_threadPool
-		);
+		for (size_t i = 0; i < m_numAcceptShards; ++i)
+		{
+			StartAccepting(
+				res.first->second.first,
+				res.first->second.second,
+				m_threadPool
+			);
+		}
+	}
+
+
+	AdmissionStats GetAdmissionStats(const std::string& name) const
+	{
+		auto it = m_funcMap.find(name);
+		if (it == m_funcMap.end())
+		{
+			throw Common::Exception("Function name not found.");
+		}
+		return it->second.first->GetStats();
 	}
 
 
 private: // static members:
 
+	/**
+	 * \brief An acceptor shared by the accept shards; they re-arm it from
+	 *        different io_service threads, and the acceptor must not be
+	 *        used by several threads at once, so the calls are serialized
+	 *        (there's no strand to run them on, as the acceptor's executor
+	 *        is not exposed).
+	 */
+	struct SharedAcceptor
+	{
+		SharedAcceptor(std::shared_ptr<AcceptorType> acceptor) :
+			m_acceptor(std::move(acceptor)),
+			m_mutex()
+		{}
+
+		std::shared_ptr<AcceptorType> m_acceptor;
+		std::mutex m_mutex;
+	}; // struct SharedAcceptor
+
+	using ServerBinding = std::pair<
+		std::shared_ptr<AdmissionType>,
+		std::shared_ptr<SharedAcceptor>
+	>;
+
 	static void StartAccepting(
-		std::weak_ptr<DecentLambdaFunc> func,    // m_funcMap owns this object
-		std::weak_ptr<AcceptorType> acceptor,    // m_funcMap owns this object
+		std::weak_ptr<AdmissionType> admission,  // m_funcMap owns this object
+		std::weak_ptr<SharedAcceptor> acceptor,  // m_funcMap owns this object
 		std::weak_ptr<ThreadPoolType> threadPool // m_threadPool owns this object
 	)
 	{
 		auto callback =
-			[func, acceptor, threadPool](
+			[admission, acceptor, threadPool](
 				std::unique_ptr<SocketType> sock,
 				bool hasErrorOccurred
 			)
 			{
-				auto funcPtr = func.lock();
+				auto admissionPtr = admission.lock();
 				auto acceptorPtr = acceptor.lock();
 				auto threadPoolPtr = threadPool.lock();
 
 				if (
 					!hasErrorOccurred &&
 					(threadPoolPtr != nullptr) &&
-					(funcPtr != nullptr)
+					(admissionPtr != nullptr)
 				)
 				{
 					// no error occurred
@@ -121,18 +190,17 @@ private: // static members:
 					if (acceptorPtr != nullptr)
 					{
 						// Repeat to accept new connection
-						StartAccepting(func, acceptor, threadPool);
+						StartAccepting(admission, acceptor, threadPool);
 					}
 
-					// proceed to handle the call
-					threadPoolPtr->AddTask(
-						Common::Internal::Obj::Internal::make_unique<
-							LambdaFuncTask
-						>(
-							funcPtr,
-							std::move(sock)
-						)
-					);
+					// proceed to handle the call, unless it's queued or shed,
+					// which is decided before any work is done for it
+					auto task = admissionPtr->Admit(std::move(sock));
+					if (task == nullptr)
+					{
+						return;
+					}
+					threadPoolPtr->AddTask(std::move(task));
 				}
 			};
 
@@ -142,7 +210,8 @@ private: // static members:
 			Common::Platform::Print::StrDebug(
 				"LambdaFuncServer - Listening for incoming connection..."
 			);
-			acceptorPtr->AsyncAccept(std::move(callback));
+			std::lock_guard<std::mutex> lock(acceptorPtr->m_mutex);
+			acceptorPtr->m_acceptor->AsyncAccept(std::move(callback));
 		}
 	}
 
@@ -150,6 +219,7 @@ private:
 
 	std::shared_ptr<Config::EndpointsMgr> m_endpointsMgr;
 	std::shared_ptr<ThreadPoolType> m_threadPool;
+	size_t m_numAcceptShards;
 
 	std::unordered_map<std::string, ServerBinding> m_funcMap;
 
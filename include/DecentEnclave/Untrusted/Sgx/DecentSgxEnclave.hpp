@@ -8,9 +8,11 @@
 
 #ifdef DECENT_ENCLAVE_PLATFORM_SGX_UNTRUSTED
 
+#include <memory>
 #include <vector>
 
 #include "../DecentEnclaveBase.hpp"
+#include "EcallGate.hpp"
 #include "SgxEnclave.hpp"
 
 
@@ -51,14 +53,38 @@ public: // static members:
 	using EncBase = DecentEnclaveBase;
 	using SgxBase = SgxEnclave;
 
+	/**
+	 * \brief The TCS budget of the default ecall gate, i.e., the TCSNum in
+	 *        the enclave configuration, which the build should define as
+	 *        `DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM`, next to the image path;
+	 *        if it doesn't, the ecalls are not bounded.
+	 */
+#ifdef DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM
+	static constexpr size_t sk_defaultNumTcs =
+		DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM;
+#else // DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM
+	static constexpr size_t sk_defaultNumTcs = EcallGate::sk_unlimited;
+#endif // DECENT_ENCLAVE_PLATFORM_SGX_TCS_NUM
+
 public:
 
+	/**
+	 * \param ecallGate The gate bounding the lambda call and heartbeat
+	 *        ecalls to the TCS budget of this enclave; by default, it's
+	 *        `sk_defaultNumTcs`, with one TCS reserved for the heartbeats.
+	 */
 	DecentSgxEnclave(
 		const std::vector<uint8_t>& authList,
 		const std::string& enclaveImgPath = DECENT_ENCLAVE_PLATFORM_SGX_IMAGE,
-		const std::string& launchTokenPath = DECENT_ENCLAVE_PLATFORM_SGX_TOKEN
+		const std::string& launchTokenPath = DECENT_ENCLAVE_PLATFORM_SGX_TOKEN,
+		std::shared_ptr<EcallGate> ecallGate = nullptr
 	) :
-		SgxBase(enclaveImgPath, launchTokenPath)
+		SgxBase(enclaveImgPath, launchTokenPath),
+		m_ecallGate(
+			ecallGate != nullptr ?
+				std::move(ecallGate) :
+				MakeDefaultEcallGate()
+		)
 	{
 		sgx_status_t funcRet = SGX_ERROR_UNEXPECTED;
 		sgx_status_t edgeRet = ecall_decent_common_init(
@@ -99,10 +125,16 @@ public:
 	) override
 	{
 		sgx_status_t funcRet = SGX_ERROR_UNEXPECTED;
-		sgx_status_t edgeRet = ecall_decent_lambda_handler(
-			m_encId,
-			&funcRet,
-			sock.get()
+		sgx_status_t edgeRet = m_ecallGate->Call(
+			EcallPriority::LambdaCall,
+			[this, &funcRet, &sock]()
+			{
+				return ecall_decent_lambda_handler(
+					m_encId,
+					&funcRet,
+					sock.get()
+				);
+			}
 		);
 		DECENTENCLAVE_CHECK_SGX_RUNTIME_ERROR(
 			edgeRet,
@@ -123,9 +155,12 @@ public:
 	virtual void Heartbeat() override
 	{
 		sgx_status_t funcRet = SGX_ERROR_UNEXPECTED;
-		sgx_status_t edgeRet = ecall_decent_heartbeat(
-			m_encId,
-			&funcRet
+		sgx_status_t edgeRet = m_ecallGate->Call(
+			EcallPriority::Heartbeat,
+			[this, &funcRet]()
+			{
+				return ecall_decent_heartbeat(m_encId, &funcRet);
+			}
 		);
 		DECENTENCLAVE_CHECK_SGX_RUNTIME_ERROR(
 			edgeRet,
@@ -138,6 +173,26 @@ public:
 	}
 
 
+	const EcallGate& GetEcallGate() const
+	{
+		return *m_ecallGate;
+	}
+
+
+private: // static members:
+
+	static std::shared_ptr<EcallGate> MakeDefaultEcallGate()
+	{
+		// copied, since `make_shared` takes it by reference
+		const size_t numTcs = sk_defaultNumTcs;
+		return std::make_shared<EcallGate>(numTcs);
+	}
+
+private:
+
+	std::shared_ptr<EcallGate> m_ecallGate;
+
+
 }; // class DecentSgxEnclave
 
 
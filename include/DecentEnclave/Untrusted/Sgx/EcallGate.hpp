@@ -0,0 +1,383 @@
+// Copyright (c) 2023 Haofan Zheng
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#pragma once
+
+
+#ifdef DECENT_ENCLAVE_PLATFORM_SGX_UNTRUSTED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include <sgx_error.h>
+
+#include "../../Common/Exceptions.hpp"
+
+
+namespace DecentEnclave
+{
+namespace Untrusted
+{
+namespace Sgx
+{
+
+
+/**
+ * \brief Priorities of the gated ecalls; the lower value goes first.
+ */
+enum class EcallPriority : size_t
+{
+	Heartbeat = 0,
+	LambdaCall = 1,
+}; // enum class EcallPriority
+
+
+struct EcallPriorityStats
+{
+	/**
+	 * \brief Bucket 0 counts waits shorter than 1us, and bucket i (> 0)
+	 *        counts waits in [2^(i-1), 2^i) us; the last bucket also
+	 *        counts the longer ones.
+	 */
+	static constexpr size_t sk_numHistBuckets = 32;
+
+	uint64_t m_numCalls;
+	/**
+	 * \brief Calls that had to wait for a TCS.
+	 */
+	uint64_t m_numWaited;
+	uint64_t m_totalWaitUs;
+	uint64_t m_maxWaitUs;
+	size_t m_currWaiting;
+	size_t m_maxWaiting;
+	std::array<uint64_t, sk_numHistBuckets> m_waitHist;
+}; // struct EcallPriorityStats
+
+
+struct EcallGateStats
+{
+	static constexpr size_t sk_numPriorities = 2;
+
+	size_t m_numTcs;
+	size_t m_numHeartbeatTcs;
+	size_t m_currInUse;
+	size_t m_maxInUse;
+	/**
+	 * \brief Max number of calls in use or waiting at the same time, i.e.,
+	 *        the number of TCS that would have avoided all waits.
+	 */
+	size_t m_maxDemand;
+	/**
+	 * \brief Ecalls retried because the enclave still ran out of TCS
+	 *        (e.g., used by ecalls not going through the gate).
+	 */
+	uint64_t m_numOutOfTcsRetries;
+	std::array<EcallPriorityStats, sk_numPriorities> m_priorities;
+}; // struct EcallGateStats
+
+
+/**
+ * \brief Bounds the ecalls in progress to the TCS budget of an enclave;
+ *        the excess calls wait, in FIFO order within each priority, for a
+ *        TCS to be handed over to them, instead of failing with
+ *        `SGX_ERROR_OUT_OF_TCS`.
+ *        The budget should leave room for the ecalls not going through the
+ *        gate, e.g., the callbacks of the async socket operations.
+ *        Some of the TCS are reserved for the heartbeats, so they are not
+ *        starved by the lambda calls, which may hold a TCS for the whole
+ *        life of a keep-alive connection; the reserved TCS are also free
+ *        most of the time for the ecalls not going through the gate.
+ */
+class EcallGate
+{
+public: // static members:
+
+	using ClockType = std::chrono::steady_clock;
+
+	static constexpr size_t sk_numPriorities = EcallGateStats::sk_numPriorities;
+	static constexpr size_t sk_unlimited = std::numeric_limits<size_t>::max();
+
+	/**
+	 * \brief Holds a TCS from the gate until it's destroyed.
+	 */
+	class Slot
+	{
+	public:
+
+		Slot(EcallGate& gate, EcallPriority priority) :
+			m_gate(gate)
+		{
+			m_gate.Acquire(priority);
+		}
+
+		~Slot()
+		{
+			m_gate.Release();
+		}
+
+		Slot(const Slot&) = delete;
+		Slot& operator=(const Slot&) = delete;
+
+	private:
+
+		EcallGate& m_gate;
+
+	}; // class Slot
+
+public:
+
+	/**
+	 * \param numTcs The TCS budget; `sk_unlimited` makes the gate only
+	 *               collect the stats.
+	 * \param numHeartbeatTcs Number of TCS, out of the budget, that only the
+	 *                        heartbeats can take; it must be less than the
+	 *                        budget.
+	 */
+	EcallGate(size_t numTcs = sk_unlimited, size_t numHeartbeatTcs = 1) :
+		m_numTcs(numTcs),
+		m_numHeartbeatTcs(numHeartbeatTcs),
+		m_mutex(),
+		m_waiters(),
+		m_stats()
+	{
+		if (m_numTcs == 0)
+		{
+			throw Common::Exception("EcallGate - The TCS budget is zero");
+		}
+		if (m_numHeartbeatTcs >= m_numTcs)
+		{
+			throw Common::Exception(
+				"EcallGate - The TCS budget leaves no TCS for the lambda calls"
+			);
+		}
+		m_stats.m_numTcs = m_numTcs;
+		m_stats.m_numHeartbeatTcs = m_numHeartbeatTcs;
+	}
+
+	~EcallGate() = default;
+
+	EcallGate(const EcallGate&) = delete;
+	EcallGate& operator=(const EcallGate&) = delete;
+
+	/**
+	 * \brief Make the ecall `func` (`sgx_status_t()`) once a TCS is
+	 *        available; while it returns `SGX_ERROR_OUT_OF_TCS`, it's tried
+	 *        again, up to `maxRetries` times.
+	 *
+	 * \return What the last call to `func` returned.
+	 */
+	template<typename _EcallFunc>
+	sgx_status_t Call(
+		EcallPriority priority,
+		_EcallFunc func,
+		size_t maxRetries = 100
+	)
+	{
+		Slot slot(*this, priority);
+
+		sgx_status_t ret = func();
+		for (
+			size_t i = 0;
+			(ret == SGX_ERROR_OUT_OF_TCS) && (i < maxRetries);
+			++i
+		)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_stats.m_numOutOfTcsRetries;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			ret = func();
+		}
+		return ret;
+	}
+
+	/**
+	 * \brief Number of ecalls in progress or waiting.
+	 */
+	size_t GetNumOutstanding() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats.m_currInUse + AfterLockNumWaiting();
+	}
+
+	EcallGateStats GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+private: // static members:
+
+	static size_t ToHistBucket(uint64_t waitUs)
+	{
+		static constexpr size_t sk_lastBucket =
+			EcallPriorityStats::sk_numHistBuckets - 1;
+
+		size_t bucket = 0;
+		while ((waitUs > 0) && (bucket < sk_lastBucket))
+		{
+			waitUs >>= 1;
+			++bucket;
+		}
+		return bucket;
+	}
+
+private:
+
+	struct Waiter
+	{
+		Waiter() :
+			m_cond(),
+			m_isGranted(false)
+		{}
+
+		std::condition_variable m_cond;
+		bool m_isGranted;
+	}; // struct Waiter
+
+	void Acquire(EcallPriority priority)
+	{
+		const size_t prioIdx = static_cast<size_t>(priority);
+		EcallPriorityStats& prioStats = m_stats.m_priorities.at(prioIdx);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		++prioStats.m_numCalls;
+
+		if (
+			(m_stats.m_currInUse < AfterLockGetLimit(prioIdx)) &&
+			(AfterLockNumWaitingAhead(prioIdx) == 0)
+		)
+		{
+			AfterLockOnGranted(prioStats, 0);
+			return;
+		}
+
+		// wait for a TCS to be handed over by `Release`
+		const ClockType::time_point start = ClockType::now();
+		Waiter waiter;
+		m_waiters[prioIdx].push_back(&waiter);
+		++prioStats.m_numWaited;
+		++prioStats.m_currWaiting;
+		if (prioStats.m_currWaiting > prioStats.m_maxWaiting)
+		{
+			prioStats.m_maxWaiting = prioStats.m_currWaiting;
+		}
+		AfterLockUpdateDemand();
+
+		waiter.m_cond.wait(lock, [&waiter](){ return waiter.m_isGranted; });
+
+		--prioStats.m_currWaiting;
+		const uint64_t waitUs = static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::microseconds>(
+				ClockType::now() - start
+			).count()
+		);
+		// the TCS is already counted in use by `Release`
+		--m_stats.m_currInUse;
+		AfterLockOnGranted(prioStats, waitUs);
+	}
+
+	void Release()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t prioIdx = 0; prioIdx < sk_numPriorities; ++prioIdx)
+		{
+			std::deque<Waiter*>& waiters = m_waiters[prioIdx];
+			if (
+				!waiters.empty() &&
+				((m_stats.m_currInUse - 1) < AfterLockGetLimit(prioIdx))
+			)
+			{
+				// hand the TCS over, so no new caller can take it meanwhile
+				Waiter* waiter = waiters.front();
+				waiters.pop_front();
+				waiter->m_isGranted = true;
+				waiter->m_cond.notify_one();
+				return;
+			}
+		}
+		--m_stats.m_currInUse;
+	}
+
+	void AfterLockOnGranted(EcallPriorityStats& prioStats, uint64_t waitUs)
+	{
+		++m_stats.m_currInUse;
+		if (m_stats.m_currInUse > m_stats.m_maxInUse)
+		{
+			m_stats.m_maxInUse = m_stats.m_currInUse;
+		}
+		AfterLockUpdateDemand();
+
+		prioStats.m_totalWaitUs += waitUs;
+		if (waitUs > prioStats.m_maxWaitUs)
+		{
+			prioStats.m_maxWaitUs = waitUs;
+		}
+		++prioStats.m_waitHist[ToHistBucket(waitUs)];
+	}
+
+	void AfterLockUpdateDemand()
+	{
+		const size_t demand = m_stats.m_currInUse + AfterLockNumWaiting();
+		if (demand > m_stats.m_maxDemand)
+		{
+			m_stats.m_maxDemand = demand;
+		}
+	}
+
+	size_t AfterLockNumWaiting() const
+	{
+		return AfterLockNumWaitingAhead(sk_numPriorities - 1);
+	}
+
+	/**
+	 * \brief Number of the waiting calls with a priority higher than or
+	 *        equal to the given one.
+	 */
+	size_t AfterLockNumWaitingAhead(size_t prioIdx) const
+	{
+		size_t num = 0;
+		for (size_t i = 0; i <= prioIdx; ++i)
+		{
+			num += m_waiters[i].size();
+		}
+		return num;
+	}
+
+	/**
+	 * \brief Max number of TCS that can be in use when a call of the given
+	 *        priority takes one.
+	 */
+	size_t AfterLockGetLimit(size_t prioIdx) const
+	{
+		return (prioIdx == static_cast<size_t>(EcallPriority::Heartbeat)) ?
+			m_numTcs :
+			(m_numTcs - m_numHeartbeatTcs);
+	}
+
+	const size_t m_numTcs;
+	const size_t m_numHeartbeatTcs;
+
+	mutable std::mutex m_mutex;
+	std::array<std::deque<Waiter*>, sk_numPriorities> m_waiters;
+	EcallGateStats m_stats;
+
+}; // class EcallGate
+
+
+} // namespace Sgx
+} // namespace Untrusted
+} // namespace DecentEnclave
+
+#endif // DECENT_ENCLAVE_PLATFORM_SGX_UNTRUSTED